@@ -0,0 +1,244 @@
+/*!
+ * @file DecoderSweep.cpp
+ * Run the instruction decoder over a large part of the 32-bit encoding space, to check it and to
+ * measure how fast it is.
+ */
+
+#include "DecoderSweep.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include "InstructionDecode.h"
+#include "LinkedObjectFile.h"
+#include "util/ThreadPool.h"
+#include "util/Timer.h"
+
+#ifdef __linux__
+#include <csetjmp>
+#include <csignal>
+#endif
+
+namespace {
+constexpr uint32_t WORDS_PER_OPCODE = 1 << 26;
+constexpr uint32_t WORDS_PER_CHUNK = 1 << 16;
+constexpr size_t MAX_DIFFERENCES_SHOWN = 8;
+
+struct SweepWorker {
+  std::vector<uint64_t> decoded_by_kind;
+  std::vector<uint64_t> failed_by_kind;
+  std::vector<uint32_t> words;
+  std::vector<InstructionKind> kinds;
+  std::vector<uint8_t> checks_ok;
+  uint64_t operand_count = 0;
+  uint64_t difference_count = 0;
+  std::vector<uint32_t> differences;  // the first few words the reference decoder disagrees on
+  double opcode_seconds = 0;
+  double instruction_seconds = 0;
+
+  // branch targets in the sweep are added as labels to this file.
+  LinkedObjectFile file;
+};
+
+/*!
+ * Get the n-th word to sweep for an opcode. When sampling, the samples are spread over all of the
+ * lower 26 bits by multiplying by an odd constant, which visits a different word for each n.
+ */
+uint32_t sweep_word(uint32_t opcode, uint32_t n, bool full) {
+  uint32_t lower = full ? n : (n * 0x9e3779b1) & (WORDS_PER_OPCODE - 1);
+  return (opcode << 26) | lower;
+}
+
+#ifdef __linux__
+// a failed assert calls abort(), which raises SIGABRT. While decoding, the handler jumps back to
+// decode_word, so the sweep can count it as a failure and keep going.
+thread_local sigjmp_buf* t_abort_jump = nullptr;
+
+void on_abort(int) {
+  if (t_abort_jump) {
+    siglongjmp(*t_abort_jump, 1);
+  }
+}
+#endif
+
+/*!
+ * Decode a word with decode_instruction. Returns false if it failed an assert.
+ */
+bool decode_word(SweepWorker& worker, uint32_t word) {
+#ifdef __linux__
+  sigjmp_buf jump;
+  if (sigsetjmp(jump, 0)) {
+    t_abort_jump = nullptr;
+    return false;
+  }
+  t_abort_jump = &jump;
+#endif
+  auto instr = decode_instruction(LinkedWord(word), worker.file, 0, 0);
+  worker.operand_count += instr.n_src + instr.n_dst;
+#ifdef __linux__
+  t_abort_jump = nullptr;
+#endif
+  return true;
+}
+
+/*!
+ * Check that the reference decoder gets the same result as try_decode_opcode and extract_field.
+ */
+bool same_as_reference(uint32_t word, bool checks_ok, InstructionKind kind) {
+  InstructionKind ref_kind;
+  bool ref_checks_ok = try_decode_opcode_reference(word, &ref_kind);
+  if (ref_checks_ok != checks_ok) {
+    return false;
+  }
+  if (!checks_ok) {
+    // the original decoder stopped at the first failed assert, so the kind doesn't mean anything.
+    return true;
+  }
+  if (ref_kind != kind) {
+    return false;
+  }
+
+  auto& info = gOpcodeInfo[int(kind)];
+  for (int i = 0; i < info.step_count; i++) {
+    auto field = info.steps[i].field;
+    if (extract_field(word, field) != extract_field_reference(word, field)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+const char* kind_name(int kind) {
+  if (kind == int(InstructionKind::UNKNOWN)) {
+    return "unknown";
+  }
+  return gOpcodeInfo[kind].name.c_str();
+}
+}  // namespace
+
+/*!
+ * Decode words from every major opcode, and print a histogram of the InstructionKinds found.
+ * Words which fail one of the checks that decode_instruction asserts are counted as failures
+ * instead of stopping the program. Only words which pass are decoded with decode_instruction, and
+ * on Linux, an assert failing inside of decode_instruction is also caught and counted.
+ * Every word is also decoded with the original decoder, and any word where the kind, the checks,
+ * or an operand field is different is counted and reported.
+ */
+void run_decoder_sweep(const DecoderSweepSettings& settings, ThreadPool& pool) {
+  Timer timer;
+  uint32_t words_per_opcode =
+      settings.full ? WORDS_PER_OPCODE : std::min(settings.samples_per_opcode, WORDS_PER_OPCODE);
+  bool exhaustive = words_per_opcode == WORDS_PER_OPCODE;
+  uint32_t chunks_per_opcode = (words_per_opcode + WORDS_PER_CHUNK - 1) / WORDS_PER_CHUNK;
+
+  std::vector<SweepWorker> workers(pool.size());
+  for (auto& worker : workers) {
+    worker.decoded_by_kind.resize(int(InstructionKind::EE_OP_MAX));
+    worker.failed_by_kind.resize(int(InstructionKind::EE_OP_MAX));
+    worker.words.resize(WORDS_PER_CHUNK);
+    worker.kinds.resize(WORDS_PER_CHUNK);
+    worker.checks_ok.resize(WORDS_PER_CHUNK);
+    worker.file.set_segment_count(1);
+  }
+
+#ifdef __linux__
+  struct sigaction abort_action = {}, old_abort_action = {};
+  abort_action.sa_handler = on_abort;
+  abort_action.sa_flags = SA_NODEFER;  // so SIGABRT isn't left blocked after jumping out.
+  sigaction(SIGABRT, &abort_action, &old_abort_action);
+#endif
+
+  pool.parallel_for(64 * chunks_per_opcode, [&](size_t idx, int worker_id) {
+    auto& worker = workers.at(worker_id);
+    uint32_t opcode = idx / chunks_per_opcode;
+    uint32_t first = (idx % chunks_per_opcode) * WORDS_PER_CHUNK;
+    uint32_t count = std::min(WORDS_PER_CHUNK, words_per_opcode - first);
+    for (uint32_t i = 0; i < count; i++) {
+      worker.words[i] = sweep_word(opcode, first + i, exhaustive);
+    }
+
+    Timer opcode_timer;
+    for (uint32_t i = 0; i < count; i++) {
+      worker.checks_ok[i] = try_decode_opcode(worker.words[i], &worker.kinds[i]);
+    }
+    worker.opcode_seconds += opcode_timer.getSeconds();
+
+    Timer instruction_timer;
+    for (uint32_t i = 0; i < count; i++) {
+      if (worker.checks_ok[i] && decode_word(worker, worker.words[i])) {
+        worker.decoded_by_kind[int(worker.kinds[i])]++;
+      } else {
+        worker.failed_by_kind[int(worker.kinds[i])]++;
+      }
+    }
+    worker.instruction_seconds += instruction_timer.getSeconds();
+
+    for (uint32_t i = 0; i < count; i++) {
+      if (!same_as_reference(worker.words[i], worker.checks_ok[i], worker.kinds[i])) {
+        worker.difference_count++;
+        if (worker.differences.size() < MAX_DIFFERENCES_SHOWN) {
+          worker.differences.push_back(worker.words[i]);
+        }
+      }
+    }
+  });
+
+#ifdef __linux__
+  sigaction(SIGABRT, &old_abort_action, nullptr);
+#endif
+
+  std::vector<uint64_t> decoded_by_kind(int(InstructionKind::EE_OP_MAX));
+  std::vector<uint64_t> failed_by_kind(int(InstructionKind::EE_OP_MAX));
+  uint64_t operand_count = 0, difference_count = 0;
+  std::vector<uint32_t> differences;
+  double opcode_seconds = 0, instruction_seconds = 0;
+  for (auto& worker : workers) {
+    difference_count += worker.difference_count;
+    differences.insert(differences.end(), worker.differences.begin(), worker.differences.end());
+    for (size_t i = 0; i < decoded_by_kind.size(); i++) {
+      decoded_by_kind[i] += worker.decoded_by_kind[i];
+      failed_by_kind[i] += worker.failed_by_kind[i];
+    }
+    operand_count += worker.operand_count;
+    opcode_seconds += worker.opcode_seconds;
+    instruction_seconds += worker.instruction_seconds;
+  }
+
+  uint64_t total_words = uint64_t(64) * words_per_opcode;
+  uint64_t total_decoded = 0, total_failed = 0;
+  for (size_t i = 0; i < decoded_by_kind.size(); i++) {
+    total_decoded += decoded_by_kind[i];
+    total_failed += failed_by_kind[i];
+  }
+  uint64_t total_unknown = decoded_by_kind[int(InstructionKind::UNKNOWN)];
+
+  printf("Decoder sweep (%s):\n", exhaustive ? "all words" : "sampled");
+  printf(" %lu words (%u per major opcode) in %.1f ms with %d threads\n",
+         (unsigned long)total_words, words_per_opcode, timer.getMs(), pool.size());
+  printf(" decoded %lu (%.3f %%), unknown %lu, failed asserts %lu, %lu operands\n",
+         (unsigned long)(total_decoded - total_unknown),
+         100. * double(total_decoded - total_unknown) / double(total_words),
+         (unsigned long)total_unknown, (unsigned long)total_failed, (unsigned long)operand_count);
+  printf(" opcode decode: %.1f M words/sec per thread\n", total_words / opcode_seconds / 1.e6);
+  printf(" instruction decode: %.1f M words/sec per thread\n",
+         total_decoded / instruction_seconds / 1.e6);
+
+  printf(" differences from the reference decoder: %lu\n", (unsigned long)difference_count);
+  std::sort(differences.begin(), differences.end());
+  for (size_t i = 0; i < differences.size() && i < MAX_DIFFERENCES_SHOWN; i++) {
+    InstructionKind kind, ref_kind;
+    bool checks_ok = try_decode_opcode(differences[i], &kind);
+    bool ref_checks_ok = try_decode_opcode_reference(differences[i], &ref_kind);
+    bool same_kind = checks_ok == ref_checks_ok && kind == ref_kind;
+    printf("  #x%08x: %s%s, reference %s%s%s\n", differences[i], kind_name(int(kind)),
+           checks_ok ? "" : " (failed)", kind_name(int(ref_kind)), ref_checks_ok ? "" : " (failed)",
+           same_kind ? " (operand fields differ)" : "");
+  }
+
+  printf(" %-16s %12s %12s\n", "kind", "decoded", "failed");
+  for (int i = 0; i < int(InstructionKind::EE_OP_MAX); i++) {
+    if (decoded_by_kind[i] || failed_by_kind[i]) {
+      printf(" %-16s %12lu %12lu\n", kind_name(i), (unsigned long)decoded_by_kind[i],
+             (unsigned long)failed_by_kind[i]);
+    }
+  }
+}
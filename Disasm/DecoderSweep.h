@@ -0,0 +1,21 @@
+/*!
+ * @file DecoderSweep.h
+ * Run the instruction decoder over a large part of the 32-bit encoding space, to check it and to
+ * measure how fast it is.
+ */
+
+#ifndef JAK_DISASSEMBLER_DECODERSWEEP_H
+#define JAK_DISASSEMBLER_DECODERSWEEP_H
+
+#include <cstdint>
+
+class ThreadPool;
+
+struct DecoderSweepSettings {
+  bool full = false;                      // every 32-bit word
+  uint32_t samples_per_opcode = 1 << 20;  // if not full, this many words per major opcode
+};
+
+void run_decoder_sweep(const DecoderSweepSettings& settings, ThreadPool& pool);
+
+#endif  // JAK_DISASSEMBLER_DECODERSWEEP_H
@@ -7,51 +7,118 @@
 #include "Instruction.h"
 #include "LinkedObjectFile.h"
 #include <cassert>
+#include "util/BinaryReader.h"
+#include "util/BinaryWriter.h"
+
+namespace {
+/*!
+ * Append an integer in decimal, the same as std::to_string would print it.
+ */
+void append_int(std::string& dest, int32_t value) {
+  char buff[12];
+  char* end = buff + sizeof(buff);
+  char* ptr = end;
+  // work with the magnitude as unsigned, so INT32_MIN works.
+  uint32_t magnitude = value < 0 ? 0u - uint32_t(value) : uint32_t(value);
+  do {
+    *(--ptr) = char('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude);
+  if (value < 0) {
+    *(--ptr) = '-';
+  }
+  dest.append(ptr, end - ptr);
+}
+}  // namespace
 
 /*!
  * Convert atom to a string for disassembly.
  */
 std::string InstructionAtom::to_string(const LinkedObjectFile& file) const {
+  std::string result;
+  append_to(result, file);
+  return result;
+}
+
+/*!
+ * The original way of converting an atom to a string, which makes a new string for every atom.
+ * Only used to compare against append_to in --print-alloc-bench.
+ */
+std::string InstructionAtom::to_string_reference(const LinkedObjectFile& file) const {
   switch (kind) {
     case REGISTER:
-      return reg.to_string();
+      return get_reg().to_string();
     case IMM:
-      return std::to_string(imm);
+      return std::to_string(get_imm());
     case LABEL:
-      return file.get_label_name(label_id);
+      return file.get_label_name(get_label());
     case VU_ACC:
       return "acc";
     case VU_Q:
       return "Q";
     case IMM_SYM:
-      return sym;
+      return get_sym(file);
+    default:
+      assert(false);
+  }
+}
+
+/*!
+ * Append the disassembly of this atom to dest. Doesn't allocate if dest has enough space.
+ */
+void InstructionAtom::append_to(std::string& dest, const LinkedObjectFile& file) const {
+  switch (kind) {
+    case REGISTER:
+      dest.append(get_reg().to_charp());
+      break;
+    case IMM:
+      append_int(dest, value);
+      break;
+    case LABEL:
+      dest.append(file.get_label_name(value));
+      break;
+    case VU_ACC:
+      dest.append("acc");
+      break;
+    case VU_Q:
+      dest.push_back('Q');
+      break;
+    case IMM_SYM:
+      dest.append(file.get_symbol_name(value));
+      break;
     default:
       assert(false);
   }
 }
 
+/*!
+ * Set the kind and value. The value must fit in 24 bits.
+ */
+void InstructionAtom::set_value(AtomKind new_kind, int32_t new_value) {
+  assert(new_value >= -(1 << 23) && new_value < (1 << 23));
+  kind = new_kind;
+  value = new_value;
+}
+
 /*!
  * Make this atom a register.
  */
 void InstructionAtom::set_reg(Register r) {
-  kind = REGISTER;
-  reg = r;
+  set_value(REGISTER, r.to_id());
 }
 
 /*!
  * Make this atom an immediate.
  */
 void InstructionAtom::set_imm(int32_t i) {
-  kind = IMM;
-  imm = i;
+  set_value(IMM, i);
 }
 
 /*!
  * Make this atom a label.
  */
 void InstructionAtom::set_label(int id) {
-  kind = LABEL;
-  label_id = id;
+  set_value(LABEL, id);
 }
 
 /*!
@@ -69,11 +136,10 @@ void InstructionAtom::set_vu_q() {
 }
 
 /*!
- * Make this atom a symbol.
+ * Make this atom a symbol, by its id in the LinkedObjectFile.
  */
-void InstructionAtom::set_sym(std::string _sym) {
-  kind = IMM_SYM;
-  sym = std::move(_sym);
+void InstructionAtom::set_sym(int symbol_id) {
+  set_value(IMM_SYM, symbol_id);
 }
 
 /*!
@@ -81,7 +147,7 @@ void InstructionAtom::set_sym(std::string _sym) {
  */
 Register InstructionAtom::get_reg() const {
   assert(kind == REGISTER);
-  return reg;
+  return Register::from_id(uint16_t(value));
 }
 
 /*!
@@ -89,7 +155,7 @@ Register InstructionAtom::get_reg() const {
  */
 int32_t InstructionAtom::get_imm() const {
   assert(kind == IMM);
-  return imm;
+  return value;
 }
 
 /*!
@@ -97,15 +163,22 @@ int32_t InstructionAtom::get_imm() const {
  */
 int InstructionAtom::get_label() const {
   assert(kind == LABEL);
-  return label_id;
+  return value;
 }
 
 /*!
- * Get as symbol, or error if not a symbol.
+ * Get as symbol id, or error if not a symbol.
  */
-std::string InstructionAtom::get_sym() const {
+int InstructionAtom::get_sym_id() const {
   assert(kind == IMM_SYM);
-  return sym;
+  return value;
+}
+
+/*!
+ * Get the name of the symbol from the file's symbol table, or error if not a symbol.
+ */
+const std::string& InstructionAtom::get_sym(const LinkedObjectFile& file) const {
+  return file.get_symbol_name(get_sym_id());
 }
 
 /*!
@@ -115,10 +188,36 @@ bool InstructionAtom::is_link_or_label() const {
   return kind == IMM_SYM || kind == LABEL;
 }
 
+/*!
+ * Write this atom to a cache entry.
+ */
+void InstructionAtom::write_to(BinaryWriter& out) const {
+  out.add<uint8_t>(kind);
+  out.add<int32_t>(value);
+}
+
+/*!
+ * Read an atom written by write_to.
+ */
+void InstructionAtom::read_from(BinaryReader& in) {
+  kind = AtomKind(in.read<uint8_t>());
+  value = in.read<int32_t>();
+}
+
 /*!
  * Convert entire instruction to a string.
  */
 std::string Instruction::to_string(const LinkedObjectFile& file) const {
+  std::string result;
+  append_to(result, file);
+  return result;
+}
+
+/*!
+ * The original way of converting an instruction to a string, which builds it out of a temporary
+ * string per atom. Only used to compare against append_to in --print-alloc-bench.
+ */
+std::string Instruction::to_string_reference(const LinkedObjectFile& file) const {
   auto& info = gOpcodeInfo[(int)kind];
 
   // the name
@@ -168,33 +267,33 @@ std::string Instruction::to_string(const LinkedObjectFile& file) const {
     assert(n_dst == 0);
     assert(n_src == 3);
     result += " ";
-    result += src[0].to_string(file);
+    result += src[0].to_string_reference(file);
     result += ", ";
-    result += src[1].to_string(file);
+    result += src[1].to_string_reference(file);
     result += "(";
-    result += src[2].to_string(file);
+    result += src[2].to_string_reference(file);
     result += ")";
   } else if (info.is_load) {
     assert(n_dst == 1);
     assert(n_src == 2);
     result += " ";
-    result += dst[0].to_string(file);
+    result += dst[0].to_string_reference(file);
     result += ", ";
-    result += src[0].to_string(file);
+    result += src[0].to_string_reference(file);
     result += "(";
-    result += src[1].to_string(file);
+    result += src[1].to_string_reference(file);
     result += ")";
   } else {
     // for instructions that aren't a store or load, the dest/sources are comma separated.
     bool end_comma = false;
 
     for (uint8_t i = 0; i < n_dst; i++) {
-      result += " " + dst[i].to_string(file) + ",";
+      result += " " + dst[i].to_string_reference(file) + ",";
       end_comma = true;
     }
 
     for (uint8_t i = 0; i < n_src; i++) {
-      result += " " + src[i].to_string(file) + ",";
+      result += " " + src[i].to_string_reference(file) + ",";
       end_comma = true;
     }
 
@@ -206,6 +305,100 @@ std::string Instruction::to_string(const LinkedObjectFile& file) const {
   return result;
 }
 
+/*!
+ * Append the disassembly of the entire instruction to dest. Doesn't allocate if dest has enough
+ * space, so printers can reuse one string for all instructions.
+ */
+void Instruction::append_to(std::string& dest, const LinkedObjectFile& file) const {
+  auto& info = gOpcodeInfo[(int)kind];
+
+  // the name
+  dest.append(info.name);
+
+  // optional "interlock" specification.
+  if (il != 0xff) {
+    dest.append(il ? ".i" : ".ni");
+  }
+
+  // optional "broadcast" specification for COP2 opcodes.
+  if (cop2_bc != 0xff) {
+    switch (cop2_bc) {
+      case 0:
+        dest.push_back('x');
+        break;
+      case 1:
+        dest.push_back('y');
+        break;
+      case 2:
+        dest.push_back('z');
+        break;
+      case 3:
+        dest.push_back('w');
+        break;
+      default:
+        dest.push_back('?');
+        break;
+    }
+  }
+
+  // optional "destination" specification for COP2 opcodes.
+  if (cop2_dest != 0xff) {
+    dest.push_back('.');
+    if (cop2_dest & 8)
+      dest.push_back('x');
+    if (cop2_dest & 4)
+      dest.push_back('y');
+    if (cop2_dest & 2)
+      dest.push_back('z');
+    if (cop2_dest & 1)
+      dest.push_back('w');
+  }
+
+  // relative store and load instructions have a special syntax in MIPS
+  if (info.is_store) {
+    assert(n_dst == 0);
+    assert(n_src == 3);
+    dest.push_back(' ');
+    src[0].append_to(dest, file);
+    dest.append(", ");
+    src[1].append_to(dest, file);
+    dest.push_back('(');
+    src[2].append_to(dest, file);
+    dest.push_back(')');
+  } else if (info.is_load) {
+    assert(n_dst == 1);
+    assert(n_src == 2);
+    dest.push_back(' ');
+    dst[0].append_to(dest, file);
+    dest.append(", ");
+    src[0].append_to(dest, file);
+    dest.push_back('(');
+    src[1].append_to(dest, file);
+    dest.push_back(')');
+  } else {
+    // for instructions that aren't a store or load, the dest/sources are comma separated.
+    bool end_comma = false;
+
+    for (uint8_t i = 0; i < n_dst; i++) {
+      dest.push_back(' ');
+      dst[i].append_to(dest, file);
+      dest.push_back(',');
+      end_comma = true;
+    }
+
+    for (uint8_t i = 0; i < n_src; i++) {
+      dest.push_back(' ');
+      src[i].append_to(dest, file);
+      dest.push_back(',');
+      end_comma = true;
+    }
+
+    if (end_comma) {
+      dest.pop_back();
+    }
+  }
+}
+
 /*!
  * Was this instruction successfully decoded?
  */
@@ -302,3 +495,42 @@ int Instruction::get_label_target() const {
   }
   return result;
 }
+
+/*!
+ * Write this instruction to a cache entry. Fields are written one at a time, so padding and unused
+ * atoms never end up in the file.
+ */
+void Instruction::write_to(BinaryWriter& out) const {
+  out.add<uint16_t>(uint16_t(kind));
+  out.add<uint8_t>(n_src);
+  out.add<uint8_t>(n_dst);
+  for (int i = 0; i < n_src; i++) {
+    src[i].write_to(out);
+  }
+  for (int i = 0; i < n_dst; i++) {
+    dst[i].write_to(out);
+  }
+  out.add<uint8_t>(cop2_dest);
+  out.add<uint8_t>(cop2_bc);
+  out.add<uint8_t>(il);
+}
+
+/*!
+ * Read an instruction written by write_to into a default constructed instruction.
+ */
+void Instruction::read_from(BinaryReader& in) {
+  kind = InstructionKind(in.read<uint16_t>());
+  assert(kind < InstructionKind::EE_OP_MAX);
+  n_src = in.read<uint8_t>();
+  n_dst = in.read<uint8_t>();
+  assert(n_src <= MAX_INSTRUCTION_SOURCE && n_dst <= MAX_INTRUCTION_DEST);
+  for (int i = 0; i < n_src; i++) {
+    src[i].read_from(in);
+  }
+  for (int i = 0; i < n_dst; i++) {
+    dst[i].read_from(in);
+  }
+  cop2_dest = in.read<uint8_t>();
+  cop2_bc = in.read<uint8_t>();
+  il = in.read<uint8_t>();
+}
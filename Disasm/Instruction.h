@@ -11,15 +11,18 @@
 #include "Register.h"
 
 class LinkedObjectFile;
+class BinaryReader;
+class BinaryWriter;
 
 constexpr int MAX_INSTRUCTION_SOURCE = 3;
 constexpr int MAX_INTRUCTION_DEST = 1;
 
 // An "atom", representing a single register, immediate, etc... for use in an Instruction.
+// Packed into 4 bytes. Symbols are stored as an id in the symbol table of the LinkedObjectFile.
 struct InstructionAtom {
-  enum AtomKind {
+  enum AtomKind : uint8_t {
     REGISTER,  // An EE Register
-    IMM,       // An immediate value (stored as int32)
+    IMM,       // An immediate value (must fit in 24 bits)
     IMM_SYM,   // An immediate value (a symbolic link)
     LABEL,     // A label in a LinkedObjectFile
     VU_ACC,    // The VU0 Accumulator
@@ -27,30 +30,40 @@ struct InstructionAtom {
     INVALID
   } kind = INVALID;
 
+  // all 4 bytes are set, so atoms have no indeterminate bits.
+  InstructionAtom() : value(0) {}
+
   void set_reg(Register r);
   void set_imm(int32_t i);
   void set_label(int id);
   void set_vu_q();
   void set_vu_acc();
-  void set_sym(std::string _sym);
+  void set_sym(int symbol_id);
 
   Register get_reg() const;
   int32_t get_imm() const;
   int get_label() const;
-  std::string get_sym() const;
+  int get_sym_id() const;
+  const std::string& get_sym(const LinkedObjectFile& file) const;
 
   std::string to_string(const LinkedObjectFile& file) const;
+  std::string to_string_reference(const LinkedObjectFile& file) const;
+  void append_to(std::string& dest, const LinkedObjectFile& file) const;
 
   bool is_link_or_label() const;
 
+  void write_to(BinaryWriter& out) const;
+  void read_from(BinaryReader& in);
+
  private:
-  int32_t imm;
-  int label_id;
-  Register reg;
+  void set_value(AtomKind new_kind, int32_t new_value);
 
-  std::string sym;
+  // the immediate, register id, label id or symbol id, depending on kind.
+  int32_t value : 24;
 };
 
+static_assert(sizeof(InstructionAtom) == 4, "InstructionAtom should be packed");
+
 // An "Instruction", consisting of a "kind" (the opcode), and the source/destination atoms it
 // operates on.
 class Instruction {
@@ -58,6 +71,8 @@ class Instruction {
   InstructionKind kind = InstructionKind::UNKNOWN;
 
   std::string to_string(const LinkedObjectFile& file) const;
+  std::string to_string_reference(const LinkedObjectFile& file) const;
+  void append_to(std::string& dest, const LinkedObjectFile& file) const;
   bool is_valid() const;
 
   void add_src(InstructionAtom& a);
@@ -70,8 +85,8 @@ class Instruction {
 
   // source and destination atoms
   uint8_t n_src = 0, n_dst = 0;
-  InstructionAtom src[MAX_INSTRUCTION_SOURCE];
-  InstructionAtom dst[MAX_INTRUCTION_DEST];
+  InstructionAtom src[MAX_INSTRUCTION_SOURCE] = {};
+  InstructionAtom dst[MAX_INTRUCTION_DEST] = {};
 
   InstructionAtom& get_imm_src();
   int32_t get_imm_src_int();
@@ -80,10 +95,15 @@ class Instruction {
 
   int get_label_target() const;
 
+  void write_to(BinaryWriter& out) const;
+  void read_from(BinaryReader& in);
+
   // extra fields for some COP2 instructions.
   uint8_t cop2_dest = 0xff;  // 0xff indicates "don't print dest"
   uint8_t cop2_bc = 0xff;    // 0xff indicates "don't print bc"
   uint8_t il = 0xff;         // 0xff indicates "don't print il"
 };
 
+static_assert(sizeof(Instruction) < 32, "Instruction should be small");
+
 #endif  // NEXT_INSTRUCTION_H
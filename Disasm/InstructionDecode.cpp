@@ -10,239 +10,332 @@
 
 // utility class to extract fields of an opcode.
 struct OpcodeFields {
-  OpcodeFields(uint32_t _data) : data(_data) {}
+  constexpr OpcodeFields(uint32_t _data) : data(_data) {}
 
   // 26 - 31
-  uint32_t op() { return (data >> 26); }
+  constexpr uint32_t op() const { return (data >> 26); }
 
   //////////////
   // R - Type //
   //////////////
 
   // 21 - 25
-  uint32_t rs() { return (data >> 21) & 0x1f; }
+  constexpr uint32_t rs() const { return (data >> 21) & 0x1f; }
 
   // 16 - 20
-  uint32_t rt() { return (data >> 16) & 0x1f; }
+  constexpr uint32_t rt() const { return (data >> 16) & 0x1f; }
 
   // 11 - 15
-  uint32_t rd() { return (data >> 11) & 0x1f; }
+  constexpr uint32_t rd() const { return (data >> 11) & 0x1f; }
 
   //  6 - 10
-  uint32_t sa() { return (data >> 6) & 0x1f; }
+  constexpr uint32_t sa() const { return (data >> 6) & 0x1f; }
 
   // 0 - 5
-  uint32_t function() { return (data)&0x3f; }
-
-  ////////////////
-  // Immediates //
-  ////////////////
-
-  int32_t simm16() { return (int16_t)(data); }
-
-  int32_t zimm16() { return (uint16_t)(data); }
-
-  uint32_t imm5() { return (data >> 6) & 0x1f; }
-
-  uint32_t imm15() { return (data >> 6) & 0b111111111111111; }
+  constexpr uint32_t function() const { return (data)&0x3f; }
 
   ////////////////////
   // Floating Point //
   ////////////////////
 
-  uint32_t cop_func() { return (data >> 21) & 0x1f; }
+  constexpr uint32_t cop_func() const { return (data >> 21) & 0x1f; }
 
-  uint32_t ft() { return (data >> 16) & 0x1f; }
-
-  uint32_t fs() { return (data >> 11) & 0x1f; }
-
-  uint32_t fd() { return (data >> 6) & 0x1f; }
+  constexpr uint32_t ft() const { return (data >> 16) & 0x1f; }
 
   ////////////
   // Others //
   ////////////
 
-  uint32_t pcreg() { return (data >> 1) & 0x1f; }
+  constexpr uint32_t MMI_func() const { return (data >> 6) & 0x1f; }
 
-  uint32_t syscall() { return (data >> 6) & 0xfffff; }
+  constexpr uint32_t lower11() const { return (uint32_t)(data & 0x7ff); }
 
-  uint32_t MMI_func() { return (data >> 6) & 0x1f; }
+  constexpr uint32_t lower6() const { return (uint32_t)(data & 0b111111); }
 
-  uint32_t lower11() { return (uint32_t)(data & 0x7ff); }
+  uint32_t data;
+};
 
-  uint32_t lower6() { return (uint32_t)(data & 0b111111); }
+namespace {
 
-  uint32_t dest() { return (data >> 21) & 0b1111; }
+// a field of an instruction: (data >> shift) & mask
+struct BitField {
+  int shift;
+  uint32_t mask;
+};
 
-  uint32_t data;
+constexpr BitField OP_BITS = {26, 0x3f};
+constexpr BitField RS_BITS = {21, 0x1f};
+constexpr BitField RT_BITS = {16, 0x1f};
+constexpr BitField RD_BITS = {11, 0x1f};
+constexpr BitField SA_BITS = {6, 0x1f};
+constexpr BitField FUNCTION_BITS = {0, 0x3f};
+constexpr BitField COP_FUNC_BITS = {21, 0x1f};
+constexpr BitField FT_BITS = {16, 0x1f};
+constexpr BitField FS_BITS = {11, 0x1f};
+constexpr BitField FD_BITS = {6, 0x1f};
+constexpr BitField MMI_FUNC_BITS = {6, 0x1f};
+constexpr BitField LOWER11_BITS = {0, 0x7ff};
+constexpr BitField DEST_BITS = {21, 0xf};
+
+// a requirement that (data & mask) == value.
+struct BitCheck {
+  uint32_t mask = 0;
+  uint32_t value = 0;
+
+  constexpr bool operator==(const BitCheck& other) const {
+    return mask == other.mask && value == other.value;
+  }
 };
 
+constexpr BitCheck field_is(BitField field, uint32_t value) {
+  return {field.mask << field.shift, value << field.shift};
+}
+
+constexpr BitCheck field_is_zero(BitField field) {
+  return field_is(field, 0);
+}
+
+constexpr BitCheck operator&(BitCheck a, BitCheck b) {
+  return {a.mask | b.mask, a.value | b.value};
+}
+
+// the CO bit, which is set on all COP2 macro mode operations.
+constexpr BitCheck COP2_CO = {1 << 25, 1 << 25};
+
 //////////////////
 // OPCODE DECODE
 //////////////////
 
-static InstructionKind decode_cop2(OpcodeFields fields) {
+/*
+ * The opcode is decoded by walking a tree of lookup tables. Each table is indexed by a field of the
+ * instruction, and each entry either gives the InstructionKind, or the next table to look in.
+ * The tables are generated at compile time from the *_entry functions below, which are written like
+ * a switch based decoder, and return what should go in the table for a given value of the field.
+ *
+ * An entry can also check other bits of the instruction, either with an assert (check), or by
+ * decoding to UNKNOWN if they don't match (match).
+ */
+
+enum class DecodeTable : uint8_t {
+  NONE,
+  OP,
+  SPECIAL,
+  SYNC,
+  REGIMM,
+  COP0,
+  MF0,
+  MT0,
+  C0,
+  COP1,
+  BC1,
+  S,
+  W,
+  COP2,
+  COP2_MOVE,
+  MMI,
+  MMI0,
+  MMI1,
+  MMI2,
+  MMI3,
+  PMFHL,
+  CACHE,
+  COUNT
+};
+
+/*!
+ * The field used to index each table.
+ */
+constexpr BitField table_index(DecodeTable table) {
+  switch (table) {
+    case DecodeTable::OP:
+      return OP_BITS;
+    case DecodeTable::SPECIAL:
+      return FUNCTION_BITS;
+    case DecodeTable::SYNC:
+      return SA_BITS;
+    case DecodeTable::REGIMM:
+      return RT_BITS;
+    case DecodeTable::COP0:
+      return COP_FUNC_BITS;
+    case DecodeTable::MF0:
+    case DecodeTable::MT0:
+      return LOWER11_BITS;
+    case DecodeTable::C0:
+      return FUNCTION_BITS;
+    case DecodeTable::COP1:
+      return COP_FUNC_BITS;
+    case DecodeTable::BC1:
+      return FT_BITS;
+    case DecodeTable::S:
+    case DecodeTable::W:
+      return FUNCTION_BITS;
+    case DecodeTable::COP2:
+      return LOWER11_BITS;
+    case DecodeTable::COP2_MOVE:
+      return COP_FUNC_BITS;
+    case DecodeTable::MMI:
+      return FUNCTION_BITS;
+    case DecodeTable::MMI0:
+    case DecodeTable::MMI1:
+    case DecodeTable::MMI2:
+    case DecodeTable::MMI3:
+      return MMI_FUNC_BITS;
+    case DecodeTable::PMFHL:
+      return SA_BITS;
+    case DecodeTable::CACHE:
+      return RT_BITS;
+    default:
+      return {0, 0};
+  }
+}
+
+struct DecodeSpec {
+  InstructionKind kind = InstructionKind::UNKNOWN;
+  DecodeTable next = DecodeTable::NONE;
+  BitCheck check;  // asserted
+  BitCheck match;  // if this fails, the instruction is UNKNOWN.
+};
+
+constexpr DecodeSpec leaf(InstructionKind kind, BitCheck check = BitCheck()) {
+  return {kind, DecodeTable::NONE, check, BitCheck()};
+}
+
+constexpr DecodeSpec leaf_if(BitCheck match, InstructionKind kind) {
+  return {kind, DecodeTable::NONE, BitCheck(), match};
+}
+
+constexpr DecodeSpec table(DecodeTable next, BitCheck check = BitCheck()) {
+  return {InstructionKind::UNKNOWN, next, check, BitCheck()};
+}
+
+constexpr DecodeSpec unknown() {
+  return leaf(InstructionKind::UNKNOWN);
+}
+
+constexpr DecodeSpec cop2_move_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
-  switch (fields.lower11()) {
-    case 0b0:
-    case 0b1:
-      switch (fields.cop_func()) {
-        case 0b00001:
-          return IK::QMFC2;
+  switch (fields.cop_func()) {
+    case 0b00001:
+      return leaf(IK::QMFC2);
 
-        case 0b00101:
-          assert(((fields.data >> 1) & (0b1111111111)) == 0);
-          return IK::QMTC2;
+    case 0b00101:
+      return leaf(IK::QMTC2, field_is_zero({1, 0b1111111111}));
 
-        case 0b00010:
-          return IK::CFC2;
+    case 0b00010:
+      return leaf(IK::CFC2);
 
-        case 0b00110:
-          return IK::CTC2;
+    case 0b00110:
+      return leaf(IK::CTC2);
 
-        default:
-          return IK::UNKNOWN;
-      }
-      break;
+    default:
+      return unknown();
+  }
+}
+
+constexpr DecodeSpec cop2_entry(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  switch (fields.lower11()) {
+    case 0b0:
+    case 0b1:
+      return table(DecodeTable::COP2_MOVE);
 
     case 0b00010111100:
     case 0b00010111101:
     case 0b00010111110:
     case 0b00010111111:
-      assert(fields.data & (1 << 25));
-      return IK::VMADDA_BC;
+      return leaf(IK::VMADDA_BC, COP2_CO);
 
     case 0b00000111100:
     case 0b00000111101:
     case 0b00000111110:
     case 0b00000111111:
-      assert(fields.data & (1 << 25));
-      return IK::VADDA_BC;
+      return leaf(IK::VADDA_BC, COP2_CO);
 
     case 0b00110111100:
     case 0b00110111101:
     case 0b00110111110:
     case 0b00110111111:
-      assert(fields.data & (1 << 25));
-      return IK::VMULA_BC;
+      return leaf(IK::VMULA_BC, COP2_CO);
 
     case 0b01010111110:
-      assert(fields.data & (1 << 25));
-      return IK::VMULA;
+      return leaf(IK::VMULA, COP2_CO);
 
     case 0b01010111100:
-      assert(fields.data & (1 << 25));
-      return IK::VADDA;
+      return leaf(IK::VADDA, COP2_CO);
 
     case 0b01010111101:
-      assert(fields.data & (1 << 25));
-      return IK::VMADDA;
+      return leaf(IK::VMADDA, COP2_CO);
 
     case 0b00011111100:
     case 0b00011111101:
     case 0b00011111110:
     case 0b00011111111:
-      assert(fields.data & (1 << 25));
-      return IK::VMSUBA_BC;
+      return leaf(IK::VMSUBA_BC, COP2_CO);
 
     case 0b00101111100:
-      assert(fields.data & (1 << 25));
-      return IK::VFTOI0;
+      return leaf(IK::VFTOI0, COP2_CO);
 
     case 0b00101111101:
-      assert(fields.data & (1 << 25));
-      return IK::VFTOI4;
+      return leaf(IK::VFTOI4, COP2_CO);
 
     case 0b00101111110:
-      assert(fields.data & (1 << 25));
-      return IK::VFTOI12;
+      return leaf(IK::VFTOI12, COP2_CO);
 
     case 0b00100111100:
-      assert(fields.data & (1 << 25));
-      return IK::VITOF0;
+      return leaf(IK::VITOF0, COP2_CO);
 
     case 0b00100111110:
-      assert(fields.data & (1 << 25));
-      return IK::VITOF12;
+      return leaf(IK::VITOF12, COP2_CO);
 
     case 0b00100111111:
-      assert(fields.data & (1 << 25));
-      return IK::VITOF15;
+      return leaf(IK::VITOF15, COP2_CO);
 
     case 0b00111111100:
-      assert(fields.data & (1 << 25));
-      assert(fields.ft() == 0);
-      return IK::VMULAQ;
+      return leaf(IK::VMULAQ, COP2_CO & field_is_zero(FT_BITS));
 
     case 0b00111111101:
-      assert(fields.data & (1 << 25));
-      return IK::VABS;
+      return leaf(IK::VABS, COP2_CO);
 
     case 0b00111111111:
-      assert(fields.data & (1 << 25));
-      assert(fields.dest() == 0b1110);
-      return IK::VCLIP;
+      return leaf(IK::VCLIP, COP2_CO & field_is(DEST_BITS, 0b1110));
 
     case 0b01011111111:
-      assert(fields.dest() == 0);
-      assert(fields.ft() == 0);
-      assert(fields.fs() == 0);
-      return IK::VNOP;
+      return leaf(IK::VNOP,
+                  field_is_zero(DEST_BITS) & field_is_zero(FT_BITS) & field_is_zero(FS_BITS));
     case 0b01101111101:
-      assert(fields.data & (1 << 25));
-      return IK::VSQI;
+      return leaf(IK::VSQI, COP2_CO);
     case 0b01101111100:
-      assert(fields.data & (1 << 25));
-      return IK::VLQI;
+      return leaf(IK::VLQI, COP2_CO);
     case 0b01110111111:
-      assert(fields.dest() == 0);
-      assert(fields.ft() == 0);
-      assert(fields.fs() == 0);
-      return IK::VWAITQ;
+      return leaf(IK::VWAITQ,
+                  field_is_zero(DEST_BITS) & field_is_zero(FT_BITS) & field_is_zero(FS_BITS));
 
     case 0b01011111110:
-      assert(fields.dest() == 0b1110);
-      assert(fields.data & (1 << 25));
-      return IK::VOPMULA;
+      return leaf(IK::VOPMULA, field_is(DEST_BITS, 0b1110) & COP2_CO);
 
     case 0b01100111100:
-      assert(fields.data & (1 << 25));
-      return IK::VMOVE;
+      return leaf(IK::VMOVE, COP2_CO);
 
     case 0b01110111100:
-      assert(fields.data & (1 << 25));
-      return IK::VDIV;
+      return leaf(IK::VDIV, COP2_CO);
 
     case 0b01110111101:
-      assert(fields.fs() == 0);
-      assert(((fields.data >> 21) & 3) == 0);
-      assert(fields.data & (1 << 25));
-      return IK::VSQRT;
+      return leaf(IK::VSQRT, field_is_zero(FS_BITS) & field_is_zero({21, 3}) & COP2_CO);
 
     case 0b01111111100:
-      assert(((fields.data >> 23) & 3) == 0);
-      assert(fields.data & (1 << 25));
-      return IK::VMTIR;
+      return leaf(IK::VMTIR, field_is_zero({23, 3}) & COP2_CO);
 
     case 0b01110111110:
-      assert(fields.data & (1 << 25));
-      return IK::VRSQRT;
+      return leaf(IK::VRSQRT, COP2_CO);
 
     case 0b10000111100:
-      assert(fields.fs() == 0);
-      assert(fields.data & (1 << 25));
-      return IK::VRNEXT;
+      return leaf(IK::VRNEXT, field_is_zero(FS_BITS) & COP2_CO);
 
     case 0b10000111101:
-      assert(fields.fs() == 0);
-      assert(fields.data & (1 << 25));
-      return IK::VRGET;
+      return leaf(IK::VRGET, field_is_zero(FS_BITS) & COP2_CO);
 
     case 0b10000111111:
-      assert(fields.ft() == 0);
-      assert(fields.data & (1 << 25));
-      assert(((fields.data >> 23) & 3) == 0);
-      return IK::VRXOR;
+      return leaf(IK::VRXOR, field_is_zero(FT_BITS) & COP2_CO & field_is_zero({23, 3}));
     default:
 
       switch (fields.lower6()) {
@@ -250,590 +343,498 @@ static InstructionKind decode_cop2(OpcodeFields fields) {
         case 0b000001:
         case 0b000010:
         case 0b000011:
-          assert(fields.data & (1 << 25));
-          return IK::VADD_BC;
+          return leaf(IK::VADD_BC, COP2_CO);
 
         case 0b000100:
         case 0b000101:
         case 0b000110:
         case 0b000111:
-          assert(fields.data & (1 << 25));
-          return IK::VSUB_BC;
+          return leaf(IK::VSUB_BC, COP2_CO);
 
         case 0b001000:
         case 0b001001:
         case 0b001010:
         case 0b001011:
-          assert(fields.data & (1 << 25));
-          return IK::VMADD_BC;
+          return leaf(IK::VMADD_BC, COP2_CO);
 
         case 0b001100:
         case 0b001101:
         case 0b001110:
         case 0b001111:
-          assert(fields.data & (1 << 25));
-          return IK::VMSUB_BC;
+          return leaf(IK::VMSUB_BC, COP2_CO);
 
         case 0b010000:
         case 0b010001:
         case 0b010010:
         case 0b010011:
-          assert(fields.data & (1 << 25));
-          return IK::VMAX_BC;
+          return leaf(IK::VMAX_BC, COP2_CO);
 
         case 0b010100:
         case 0b010101:
         case 0b010110:
         case 0b010111:
-          assert(fields.data & (1 << 25));
-          return IK::VMINI_BC;
+          return leaf(IK::VMINI_BC, COP2_CO);
 
         case 0b011000:
         case 0b011001:
         case 0b011010:
         case 0b011011:
-          assert(fields.data & (1 << 25));
-          return IK::VMUL_BC;
+          return leaf(IK::VMUL_BC, COP2_CO);
 
         case 0b011100:
-          assert(fields.ft() == 0);
-          assert(fields.data & (1 << 25));
-          return IK::VMULQ;
+          return leaf(IK::VMULQ, field_is_zero(FT_BITS) & COP2_CO);
 
         case 0b100000:
-          assert(fields.data & (1 << 25));
-          return IK::VADDQ;
+          return leaf(IK::VADDQ, COP2_CO);
 
         case 0b100100:
-          assert(fields.data & (1 << 25));
-          return IK::VSUBQ;
+          return leaf(IK::VSUBQ, COP2_CO);
 
         case 0b100101:
-          assert(fields.ft() == 0);
-          assert(fields.data & (1 << 25));
-          return IK::VMSUBQ;
+          return leaf(IK::VMSUBQ, field_is_zero(FT_BITS) & COP2_CO);
 
         case 0b101000:
-          assert(fields.data & (1 << 25));
-          return IK::VADD;
+          return leaf(IK::VADD, COP2_CO);
         case 0b101001:
-          assert(fields.data & (1 << 25));
-          return IK::VMADD;
+          return leaf(IK::VMADD, COP2_CO);
         case 0b101010:
-          assert(fields.data & (1 << 25));
-          return IK::VMUL;
+          return leaf(IK::VMUL, COP2_CO);
         case 0b101011:
-          assert(fields.data & (1 << 25));
-          return IK::VMAX;
+          return leaf(IK::VMAX, COP2_CO);
         case 0b101100:
-          assert(fields.data & (1 << 25));
-          return IK::VSUB;
+          return leaf(IK::VSUB, COP2_CO);
         case 0b101101:
-          assert(fields.data & (1 << 25));
-          return IK::VMSUB;
+          return leaf(IK::VMSUB, COP2_CO);
         case 0b101110:
-          assert(fields.data & (1 << 25));
-          assert(fields.dest() == 0b1110);
-          return IK::VOPMSUB;
+          return leaf(IK::VOPMSUB, COP2_CO & field_is(DEST_BITS, 0b1110));
         case 0b101111:
-          assert(fields.data & (1 << 25));
-          return IK::VMINI;
+          return leaf(IK::VMINI, COP2_CO);
         case 0b110010:
-          assert(fields.data & (1 << 25));
-          assert(fields.dest() == 0b0);
-          return IK::VIADDI;
+          return leaf(IK::VIADDI, COP2_CO & field_is_zero(DEST_BITS));
         case 0b110100:
-          assert(fields.data & (1 << 25));
-          assert(fields.dest() == 0b0);
-          return IK::VIAND;
+          return leaf(IK::VIAND, COP2_CO & field_is_zero(DEST_BITS));
         case 0b111000:
-          assert(fields.data & (1 << 25));
-          assert(fields.dest() == 0b0);
-          return IK::VCALLMS;
+          return leaf(IK::VCALLMS, COP2_CO & field_is_zero(DEST_BITS));
         default:
-          return IK::UNKNOWN;
+          return unknown();
       }
   }
 }
 
-static InstructionKind decode_W(OpcodeFields fields) {
+constexpr DecodeSpec w_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
   switch (fields.function()) {
     case 0b100000:
-      assert(fields.ft() == 0);
-      return IK::CVTSW;
+      return leaf(IK::CVTSW, field_is_zero(FT_BITS));
     default:
-      return IK::UNKNOWN;
+      return unknown();
   }
 }
 
-static InstructionKind decode_S(OpcodeFields fields) {
+constexpr DecodeSpec s_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
   switch (fields.function()) {
     case 0b000000:
-      return IK::ADDS;
+      return leaf(IK::ADDS);
     case 0b000001:
-      return IK::SUBS;
+      return leaf(IK::SUBS);
     case 0b000010:
-      return IK::MULS;
+      return leaf(IK::MULS);
     case 0b000011:
-      return IK::DIVS;
+      return leaf(IK::DIVS);
     case 0b000101:
-      return IK::ABSS;
+      return leaf(IK::ABSS);
     case 0b000110:
-      assert(fields.ft() == 0);
-      return IK::MOVS;
+      return leaf(IK::MOVS, field_is_zero(FT_BITS));
     case 0b000111:
-      assert(fields.ft() == 0);
-      return IK::NEGS;
+      return leaf(IK::NEGS, field_is_zero(FT_BITS));
     case 0b000100:
-      assert(fields.fs() == 0);
-      return IK::SQRTS;
+      return leaf(IK::SQRTS, field_is_zero(FS_BITS));
     case 0b010110:
-      return IK::RSQRTS;
+      return leaf(IK::RSQRTS);
     case 0b011000:
-      assert(fields.fd() == 0);
-      return IK::ADDAS;
+      return leaf(IK::ADDAS, field_is_zero(FD_BITS));
     case 0b011010:
-      assert(fields.fd() == 0);
-      return IK::MULAS;
+      return leaf(IK::MULAS, field_is_zero(FD_BITS));
     case 0b011100:
-      return IK::MADDS;
+      return leaf(IK::MADDS);
     case 0b011101:
-      return IK::MSUBS;
+      return leaf(IK::MSUBS);
     case 0b011110:
-      assert(fields.fd() == 0);
-      return IK::MADDAS;
+      return leaf(IK::MADDAS, field_is_zero(FD_BITS));
     case 0b011111:
-      assert(fields.fd() == 0);
-      return IK::MSUBAS;
+      return leaf(IK::MSUBAS, field_is_zero(FD_BITS));
     case 0b100100:
-      assert(fields.ft() == 0);
-      return IK::CVTWS;
+      return leaf(IK::CVTWS, field_is_zero(FT_BITS));
     case 0b101000:
-      return IK::MAXS;
+      return leaf(IK::MAXS);
     case 0b101001:
-      return IK::MINS;
+      return leaf(IK::MINS);
     case 0b110010:
-      assert(fields.fd() == 0);
-      return IK::CEQS;
+      return leaf(IK::CEQS, field_is_zero(FD_BITS));
     case 0b110100:
-      assert(fields.fd() == 0);
-      return IK::CLTS;
+      return leaf(IK::CLTS, field_is_zero(FD_BITS));
     case 0b110110:
-      assert(fields.fd() == 0);
-      return IK::CLES;
+      return leaf(IK::CLES, field_is_zero(FD_BITS));
     default:
-      return IK::UNKNOWN;
+      return unknown();
   }
 }
 
-static InstructionKind decode_BC1(OpcodeFields fields) {
+constexpr DecodeSpec bc1_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
   switch (fields.ft()) {
     case 0b00000:
-      return IK::BC1F;
+      return leaf(IK::BC1F);
     case 0b00001:
-      return IK::BC1T;
+      return leaf(IK::BC1T);
     case 0b00010:
-      return IK::BC1FL;
+      return leaf(IK::BC1FL);
     case 0b00011:
-      return IK::BC1TL;
+      return leaf(IK::BC1TL);
     default:
-      return IK::UNKNOWN;
+      return unknown();
   }
 }
 
-static InstructionKind decode_cop1(OpcodeFields fields) {
+constexpr DecodeSpec cop1_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
   switch (fields.cop_func()) {
     case 0b00000:
-      assert(fields.sa() == 0);
-      assert(fields.function() == 0);
-      return IK::MFC1;
+      return leaf(IK::MFC1, field_is_zero(SA_BITS) & field_is_zero(FUNCTION_BITS));
     case 0b00100:
-      assert(fields.sa() == 0);
-      assert(fields.function() == 0);
-      return IK::MTC1;
+      return leaf(IK::MTC1, field_is_zero(SA_BITS) & field_is_zero(FUNCTION_BITS));
     case 0b01000:
-      return decode_BC1(fields);
+      return table(DecodeTable::BC1);
     case 0b10000:
-      return decode_S(fields);
+      return table(DecodeTable::S);
     case 0b10100:
-      return decode_W(fields);
+      return table(DecodeTable::W);
     default:
-      return IK::UNKNOWN;
+      return unknown();
   }
 }
 
-static InstructionKind decode_c0(OpcodeFields fields) {
+constexpr DecodeSpec c0_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
   switch (fields.function()) {
     case 0b011000:
-      return IK::ERET;
+      return leaf(IK::ERET);
     case 0b111000:
-      assert(fields.sa() == 0 && fields.rd() == 0 && fields.rt() == 0);
-      return IK::EI;
+      return leaf(IK::EI,
+                  field_is_zero(SA_BITS) & field_is_zero(RD_BITS) & field_is_zero(RT_BITS));
     default:
-      return IK::UNKNOWN;
+      return unknown();
   }
 }
 
-static InstructionKind decode_mt0(OpcodeFields fields) {
+constexpr DecodeSpec mt0_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
   switch (fields.lower11()) {
     case 0b00000000000:
-      return IK::MTC0;
+      return leaf(IK::MTC0);
     case 0b00000000100:
-      assert(fields.rd() == 0b11000);
-      return IK::MTDAB;
+      return leaf(IK::MTDAB, field_is(RD_BITS, 0b11000));
     case 0b00000000101:
-      assert(fields.rd() == 0b11000);
-      return IK::MTDABM;
+      return leaf(IK::MTDABM, field_is(RD_BITS, 0b11000));
     default:
-      if (fields.rd() == 0b11001 && fields.sa() == 0 && (fields.data & 1) == 1) {
-        return IK::MTPC;
+      // rd isn't part of the index, so it's matched when decoding.
+      if (fields.sa() == 0 && (fields.data & 1) == 1) {
+        return leaf_if(field_is(RD_BITS, 0b11001), IK::MTPC);
       } else {
-        return IK::UNKNOWN;
+        return unknown();
       }
   }
 }
 
-static InstructionKind decode_mf0(OpcodeFields fields) {
+constexpr DecodeSpec mf0_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
   switch (fields.lower11()) {
     case 0b0:
-      return IK::MFC0;
+      return leaf(IK::MFC0);
     default:
-      if (fields.rd() == 0b11001 && fields.sa() == 0 && (fields.data & 1) == 1) {
-        return IK::MFPC;
+      if (fields.sa() == 0 && (fields.data & 1) == 1) {
+        return leaf_if(field_is(RD_BITS, 0b11001), IK::MFPC);
       } else {
-        return IK::UNKNOWN;
+        return unknown();
       }
   }
 }
 
-static InstructionKind decode_cop0(OpcodeFields fields) {
+constexpr DecodeSpec cop0_entry(OpcodeFields fields) {
   switch (fields.cop_func()) {
     case 0b00000:
-      return decode_mf0(fields);
+      return table(DecodeTable::MF0);
     case 0b00100:
-      return decode_mt0(fields);
+      return table(DecodeTable::MT0);
     case 0b10000:
-      return decode_c0(fields);
+      return table(DecodeTable::C0);
     default:
-      return InstructionKind::UNKNOWN;
+      return unknown();
   }
 }
 
-static InstructionKind decode_mmi3(OpcodeFields fields) {
+constexpr DecodeSpec mmi3_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
   switch (fields.MMI_func()) {
     case 0b01010:
-      return IK::PINTEH;
+      return leaf(IK::PINTEH);
     case 0b01110:
-      return IK::PCPYUD;
+      return leaf(IK::PCPYUD);
     case 0b10010:
-      return IK::POR;
+      return leaf(IK::POR);
     case 0b10011:
-      return IK::PNOR;
+      return leaf(IK::PNOR);
     case 0b11011:
-      assert(fields.rs() == 0);
-      return IK::PCPYH;
+      return leaf(IK::PCPYH, field_is_zero(RS_BITS));
     default:
-      return IK::UNKNOWN;
+      return unknown();
   }
 }
 
-static InstructionKind decode_mmi2(OpcodeFields fields) {
+constexpr DecodeSpec mmi2_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
   switch (fields.MMI_func()) {
     case 0b01110:
-      return IK::PCPYLD;
+      return leaf(IK::PCPYLD);
     case 0b10000:
-      return IK::PMADDH;
+      return leaf(IK::PMADDH);
     case 0b10010:
-      return IK::PAND;
+      return leaf(IK::PAND);
     case 0b11100:
-      return IK::PMULTH;
+      return leaf(IK::PMULTH);
     case 0b11110:
-      return IK::PEXEW;
+      return leaf(IK::PEXEW);
     case 0b11111:
-      return IK::PROT3W;
+      return leaf(IK::PROT3W);
     default:
-      return IK::UNKNOWN;
+      return unknown();
   }
 }
 
-static InstructionKind decode_mmi1(OpcodeFields fields) {
+constexpr DecodeSpec mmi1_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
   switch (fields.MMI_func()) {
     case 0b00001:
-      return IK::PABSW;
+      return leaf(IK::PABSW);
     case 0b00010:
-      return IK::PCEQW;
+      return leaf(IK::PCEQW);
     case 0b00011:
-      return IK::PMINW;
+      return leaf(IK::PMINW);
     case 0b00111:
-      return IK::PMINH;
+      return leaf(IK::PMINH);
     case 0b01010:
-      return IK::PCEQB;
+      return leaf(IK::PCEQB);
     case 0b10010:
-      return IK::PEXTUW;
+      return leaf(IK::PEXTUW);
     case 0b10110:
-      return IK::PEXTUH;
+      return leaf(IK::PEXTUH);
     case 0b11010:
-      return IK::PEXTUB;
+      return leaf(IK::PEXTUB);
     default:
-      return IK::UNKNOWN;
+      return unknown();
   }
 }
 
-static InstructionKind decode_mmi0(OpcodeFields fields) {
+constexpr DecodeSpec mmi0_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
   switch (fields.MMI_func()) {
     case 0b00000:
-      return IK::PADDW;
+      return leaf(IK::PADDW);
     case 0b00001:
-      return IK::PSUBW;
+      return leaf(IK::PSUBW);
     case 0b00010:
-      return IK::PCGTW;
+      return leaf(IK::PCGTW);
     case 0b00011:
-      return IK::PMAXW;
+      return leaf(IK::PMAXW);
     case 0b00100:
-      return IK::PADDH;
+      return leaf(IK::PADDH);
     case 0b00111:
-      return IK::PMAXH;
+      return leaf(IK::PMAXH);
     case 0b10010:
-      return IK::PEXTLW;
+      return leaf(IK::PEXTLW);
     case 0b10011:
-      return IK::PPACW;
+      return leaf(IK::PPACW);
     case 0b10111:
-      return IK::PPACH;
+      return leaf(IK::PPACH);
     case 0b10110:
-      return IK::PEXTLH;
+      return leaf(IK::PEXTLH);
     case 0b11010:
-      return IK::PEXTLB;
+      return leaf(IK::PEXTLB);
     case 0b11011:
-      return IK::PPACB;
+      return leaf(IK::PPACB);
     default:
-      return IK::UNKNOWN;
+      return unknown();
   }
 }
 
-static InstructionKind decode_pmfhl(OpcodeFields fields) {
+constexpr DecodeSpec pmfhl_entry(OpcodeFields fields) {
   // the PMFHL instruction is split into several types, and we create different instructions for
   // each.
   typedef InstructionKind IK;
   switch (fields.sa()) {
     case 0b00001:
-      assert(fields.rs() == 0);
-      assert(fields.rt() == 0);
-      return IK::PMFHL_UW;
+      return leaf(IK::PMFHL_UW, field_is_zero(RS_BITS) & field_is_zero(RT_BITS));
     case 0b00000:
-      assert(fields.rs() == 0);
-      assert(fields.rt() == 0);
-      return IK::PMFHL_LW;
+      return leaf(IK::PMFHL_LW, field_is_zero(RS_BITS) & field_is_zero(RT_BITS));
     case 0b00011:
-      assert(fields.rs() == 0);
-      assert(fields.rt() == 0);
-      return IK::PMFHL_LH;
+      return leaf(IK::PMFHL_LH, field_is_zero(RS_BITS) & field_is_zero(RT_BITS));
     default:
-      return IK::UNKNOWN;
+      return unknown();
   }
 }
 
-static InstructionKind decode_mmi(OpcodeFields fields) {
+constexpr DecodeSpec mmi_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
   switch (fields.function()) {
     case 0b000100:
-      assert(fields.sa() == 0);
-      assert(fields.rt() == 0);
-      return IK::PLZCW;
+      return leaf(IK::PLZCW, field_is_zero(SA_BITS) & field_is_zero(RT_BITS));
     case 0b001000:
-      return decode_mmi0(fields);
+      return table(DecodeTable::MMI0);
     case 0b001001:
-      return decode_mmi2(fields);
+      return table(DecodeTable::MMI2);
 
     case 0b010011:
-      assert(fields.sa() == 0);
-      assert(fields.rd() == 0);
-      assert(fields.rt() == 0);
-      return IK::MTLO1;
+      return leaf(IK::MTLO1,
+                  field_is_zero(SA_BITS) & field_is_zero(RD_BITS) & field_is_zero(RT_BITS));
     case 0b010010:
-      assert(fields.sa() == 0);
-      assert(fields.rs() == 0);
-      assert(fields.rt() == 0);
-      return IK::MFLO1;
+      return leaf(IK::MFLO1,
+                  field_is_zero(SA_BITS) & field_is_zero(RS_BITS) & field_is_zero(RT_BITS));
 
     case 0b101000:
-      return decode_mmi1(fields);
+      return table(DecodeTable::MMI1);
     case 0b101001:
-      return decode_mmi3(fields);
+      return table(DecodeTable::MMI3);
     case 0b110000:
-      return decode_pmfhl(fields);
+      return table(DecodeTable::PMFHL);
     case 0b110100:
-      return IK::PSLLH;
+      return leaf(IK::PSLLH);
     case 0b110110:
-      return IK::PSRLH;
+      return leaf(IK::PSRLH);
     case 0b110111:
-      return IK::PSRAH;
+      return leaf(IK::PSRAH);
     case 0b111100:
-      return IK::PSLLW;
+      return leaf(IK::PSLLW);
     case 0b111111:
-      return IK::PSRAW;
+      return leaf(IK::PSRAW);
     default:
-      return IK::UNKNOWN;
+      return unknown();
   }
 }
 
-static InstructionKind decode_regimm(OpcodeFields files) {
+constexpr DecodeSpec regimm_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
-  switch (files.rt()) {
+  switch (fields.rt()) {
     case 0b00000:
-      return IK::BLTZ;
+      return leaf(IK::BLTZ);
     case 0b00001:
-      return IK::BGEZ;
+      return leaf(IK::BGEZ);
     case 0b00010:
-      return IK::BLTZL;
+      return leaf(IK::BLTZL);
     case 0b00011:
-      return IK::BGEZL;
+      return leaf(IK::BGEZL);
     case 0b10001:
-      return IK::BGEZAL;
+      return leaf(IK::BGEZAL);
     default:
-      return IK::UNKNOWN;
+      return unknown();
   }
 }
 
-static InstructionKind decode_sync(OpcodeFields fields) {
+constexpr DecodeSpec sync_entry(OpcodeFields fields) {
   // the "sync" opcode has a "stype" field which picks between P and L type syncs.
   // to avoid implementing this, we just split SYNC into two separate instructions.
   typedef InstructionKind IK;
   auto stype = fields.sa();
-  assert(fields.rt() == 0);
-  assert(fields.rs() == 0);
-  assert(fields.rd() == 0);
   if (stype == 0b00000) {
-    return IK::SYNCL;
+    return leaf(IK::SYNCL);
   } else if (stype == 0b10000) {
-    return IK::SYNCP;
+    return leaf(IK::SYNCP);
   } else {
-    return IK::UNKNOWN;
+    return unknown();
   }
 }
 
-static InstructionKind decode_special(OpcodeFields fields) {
+constexpr DecodeSpec special_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
   switch (fields.function()) {
     case 0b000000:
-      assert(fields.rs() == 0);
-      return IK::SLL;
+      return leaf(IK::SLL, field_is_zero(RS_BITS));
     // RESERVED
     case 0b000010:
-      assert(fields.rs() == 0);
-      return IK::SRL;
+      return leaf(IK::SRL, field_is_zero(RS_BITS));
     case 0b000011:
-      assert(fields.rs() == 0);
-      return IK::SRA;
+      return leaf(IK::SRA, field_is_zero(RS_BITS));
     case 0b000100:
-      assert(fields.sa() == 0);
-      return IK::SLLV;
+      return leaf(IK::SLLV, field_is_zero(SA_BITS));
     // RESERVED
     // SRLV
     // SRAV
     case 0b001000:
-      assert(fields.sa() == 0);
-      assert(fields.rd() == 0);
-      assert(fields.rt() == 0);
-      return IK::JR;
+      return leaf(IK::JR, field_is_zero(SA_BITS) & field_is_zero(RD_BITS) & field_is_zero(RT_BITS));
     case 0b001001:
-      assert(fields.rt() == 0);
-      assert(fields.sa() == 0);
-      return IK::JALR;
+      return leaf(IK::JALR, field_is_zero(RT_BITS) & field_is_zero(SA_BITS));
     case 0b001010:
-      assert(fields.sa() == 0);
-      return IK::MOVZ;
+      return leaf(IK::MOVZ, field_is_zero(SA_BITS));
     case 0b001011:
-      assert(fields.sa() == 0);
-      return IK::MOVN;
+      return leaf(IK::MOVN, field_is_zero(SA_BITS));
     case 0b001100:
-      return IK::SYSCALL;
+      return leaf(IK::SYSCALL);
     // BREAK
     // RESERVED
     case 0b001111:
-      return decode_sync(fields);
+      return table(DecodeTable::SYNC,
+                   field_is_zero(RT_BITS) & field_is_zero(RS_BITS) & field_is_zero(RD_BITS));
 
     case 0b010000:
-      assert(fields.rs() == 0);
-      assert(fields.rt() == 0);
-      assert(fields.sa() == 0);
-      return IK::MFHI;
+      return leaf(IK::MFHI,
+                  field_is_zero(RS_BITS) & field_is_zero(RT_BITS) & field_is_zero(SA_BITS));
     // MTHI
     case 0b010010:
-      assert(fields.rs() == 0);
-      assert(fields.rt() == 0);
-      assert(fields.sa() == 0);
-      return IK::MFLO;
+      return leaf(IK::MFLO,
+                  field_is_zero(RS_BITS) & field_is_zero(RT_BITS) & field_is_zero(SA_BITS));
     // MTLO
     case 0b010100:
-      assert(fields.sa() == 0);
-      return IK::DSLLV;
+      return leaf(IK::DSLLV, field_is_zero(SA_BITS));
     // RESERVED
     case 0b010110:
-      assert(fields.sa() == 0);
-      return IK::DSRLV;
+      return leaf(IK::DSRLV, field_is_zero(SA_BITS));
     case 0b010111:
-      assert(fields.sa() == 0);
-      return IK::DSRAV;
+      return leaf(IK::DSRAV, field_is_zero(SA_BITS));
     case 0b011000:
-      assert(fields.sa() == 0);
-      return IK::MULT3;
+      return leaf(IK::MULT3, field_is_zero(SA_BITS));
     case 0b011001:
-      assert(fields.sa() == 0);
-      return IK::MULTU3;
+      return leaf(IK::MULTU3, field_is_zero(SA_BITS));
     case 0b011010:
-      assert(fields.sa() == 0);
-      assert(fields.rd() == 0);
-      return IK::DIV;
+      return leaf(IK::DIV, field_is_zero(SA_BITS) & field_is_zero(RD_BITS));
     case 0b011011:
-      assert(fields.sa() == 0);
-      assert(fields.rd() == 0);
-      return IK::DIVU;
+      return leaf(IK::DIVU, field_is_zero(SA_BITS) & field_is_zero(RD_BITS));
     // 4x UNSUPPORTED
     // ADD
     case 0b100001:
-      assert(fields.sa() == 0);
-      return IK::ADDU;
+      return leaf(IK::ADDU, field_is_zero(SA_BITS));
     // SUB
     case 0b100011:
-      assert(fields.sa() == 0);
-      return IK::SUBU;
+      return leaf(IK::SUBU, field_is_zero(SA_BITS));
     case 0b100100:
-      assert(fields.sa() == 0);
-      return IK::AND;
+      return leaf(IK::AND, field_is_zero(SA_BITS));
     case 0b100101:
-      assert(fields.sa() == 0);
-      return IK::OR;
+      return leaf(IK::OR, field_is_zero(SA_BITS));
     case 0b100110:
-      assert(fields.sa() == 0);
-      return IK::XOR;
+      return leaf(IK::XOR, field_is_zero(SA_BITS));
     case 0b100111:
-      assert(fields.sa() == 0);
-      return IK::NOR;
+      return leaf(IK::NOR, field_is_zero(SA_BITS));
     // MFSA
     // MTSA
     case 0b101010:
-      assert(fields.sa() == 0);
-      return IK::SLT;
+      return leaf(IK::SLT, field_is_zero(SA_BITS));
     case 0b101011:
-      assert(fields.sa() == 0);
-      return IK::SLTU;
+      return leaf(IK::SLTU, field_is_zero(SA_BITS));
     // DADD
     case 0b101101:
-      return IK::DADDU;
+      return leaf(IK::DADDU);
     // DSUB
     case 0b101111:
-      return IK::DSUBU;
+      return leaf(IK::DSUBU);
     // TGE
     // TGEU
     // TLT
@@ -843,168 +844,391 @@ static InstructionKind decode_special(OpcodeFields fields) {
     // TNE
     // RESERVED
     case 0b111000:
-      assert(fields.rs() == 0);
-      return IK::DSLL;
+      return leaf(IK::DSLL, field_is_zero(RS_BITS));
     // RESERVED
     case 0b111010:
-      assert(fields.rs() == 0);
-      return IK::DSRL;
+      return leaf(IK::DSRL, field_is_zero(RS_BITS));
     case 0b111011:
-      assert(fields.rs() == 0);
-      return IK::DSRA;
+      return leaf(IK::DSRA, field_is_zero(RS_BITS));
     case 0b111100:
-      assert(fields.rs() == 0);
-      return IK::DSLL32;
+      return leaf(IK::DSLL32, field_is_zero(RS_BITS));
     // RESERVED
     case 0b111110:
-      assert(fields.rs() == 0);
-      return IK::DSRL32;
+      return leaf(IK::DSRL32, field_is_zero(RS_BITS));
     case 0b111111:
-      assert(fields.rs() == 0);
-      return IK::DSRA32;
+      return leaf(IK::DSRA32, field_is_zero(RS_BITS));
     default:
-      return IK::UNKNOWN;
+      return unknown();
   }
 }
 
-static InstructionKind decode_cache(OpcodeFields fields) {
+constexpr DecodeSpec cache_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
   // there's only one cache instruction used (DXWBIN), so we just use a CACHE DXWBIN instruction
   // to avoid having to implement the full cache instruction decoding.
   switch (fields.rt()) {
     case 0b10100:
-      return IK::CACHE_DXWBIN;
+      return leaf(IK::CACHE_DXWBIN);
     default:
-      return IK::UNKNOWN;
+      return unknown();
   }
 }
 
-/*!
- * Top level opcode decode
- */
-static InstructionKind decode_opcode(uint32_t code) {
-  OpcodeFields fields(code);
+constexpr DecodeSpec op_entry(OpcodeFields fields) {
   typedef InstructionKind IK;
   switch (fields.op()) {
     case 0b000000:
-      return decode_special(fields);
+      return table(DecodeTable::SPECIAL);
     case 0b000001:
-      return decode_regimm(fields);
+      return table(DecodeTable::REGIMM);
     // J      010
     // JAL    011
     case 0b000100:
-      return IK::BEQ;
+      return leaf(IK::BEQ);
     case 0b000101:
-      return IK::BNE;
+      return leaf(IK::BNE);
     case 0b000110:
-      return IK::BLEZ;
+      return leaf(IK::BLEZ);
     case 0b000111:
-      return IK::BGTZ;
+      return leaf(IK::BGTZ);
     // ADDI  1000
     case 0b001001:
-      return IK::ADDIU;
+      return leaf(IK::ADDIU);
     case 0b001010:
-      return IK::SLTI;
+      return leaf(IK::SLTI);
     case 0b001011:
-      return IK::SLTIU;
+      return leaf(IK::SLTIU);
     case 0b001100:
-      return IK::ANDI;
+      return leaf(IK::ANDI);
     case 0b001101:
-      return IK::ORI;
+      return leaf(IK::ORI);
     case 0b001110:
-      return IK::XORI;
+      return leaf(IK::XORI);
     case 0b001111:
-      assert(fields.rs() == 0);
-      return IK::LUI;
+      return leaf(IK::LUI, field_is_zero(RS_BITS));
     case 0b010000:
-      return decode_cop0(fields);
+      return table(DecodeTable::COP0);
     case 0b010001:
-      return decode_cop1(fields);
+      return table(DecodeTable::COP1);
     case 0b010010:
-      return decode_cop2(fields);
+      return table(DecodeTable::COP2);
     //     010011:
     //  reserved
     case 0b010100:
-      return IK::BEQL;
+      return leaf(IK::BEQL);
     case 0b010101:
-      return IK::BNEL;
+      return leaf(IK::BNEL);
     //     010110
     //  blezl
     case 0b010111:
-      assert(fields.rt() == 0);
-      return IK::BGTZL;
+      return leaf(IK::BGTZL, field_is_zero(RT_BITS));
     //   0b011000:
     //  daddi
     case 0b011001:
-      return IK::DADDIU;
+      return leaf(IK::DADDIU);
     case 0b011010:
-      return IK::LDL;
+      return leaf(IK::LDL);
     case 0b011011:
-      return IK::LDR;
+      return leaf(IK::LDR);
     case 0b011100:
-      return decode_mmi(fields);
+      return table(DecodeTable::MMI);
     //   0b011101:
     // reserved
     case 0b011110:
-      return IK::LQ;
+      return leaf(IK::LQ);
     case 0b011111:
-      return IK::SQ;
+      return leaf(IK::SQ);
     case 0b100000:
-      return IK::LB;
+      return leaf(IK::LB);
     case 0b100001:
-      return IK::LH;
+      return leaf(IK::LH);
     case 0b100010:
-      return IK::LWL;
+      return leaf(IK::LWL);
     case 0b100011:
-      return IK::LW;
+      return leaf(IK::LW);
     case 0b100100:
-      return IK::LBU;
+      return leaf(IK::LBU);
     case 0b100101:
-      return IK::LHU;
+      return leaf(IK::LHU);
     case 0b100110:
-      return IK::LWR;
+      return leaf(IK::LWR);
     case 0b100111:
-      return IK::LWU;
+      return leaf(IK::LWU);
     case 0b101000:
-      return IK::SB;
+      return leaf(IK::SB);
     case 0b101001:
-      return IK::SH;
+      return leaf(IK::SH);
     case 0b101011:
-      return IK::SW;
+      return leaf(IK::SW);
     // SDL
     // SDR
     // SWR
     case 0b101111:
-      return decode_cache(fields);
+      return table(DecodeTable::CACHE);
 
     // unsupported
     case 0b110001:
-      return IK::LWC1;
+      return leaf(IK::LWC1);
     // unsupported
     case 0b110011:
-      return IK::PREF;
+      return leaf(IK::PREF);
     // unsupported
     // unsupported
     case 0b110110:
-      return IK::LQC2;
+      return leaf(IK::LQC2);
     case 0b110111:
-      return IK::LD;
+      return leaf(IK::LD);
     case 0b111001:
-      return IK::SWC1;
+      return leaf(IK::SWC1);
     case 0b111110:
-      return IK::SQC2;
+      return leaf(IK::SQC2);
     case 0b111111:
-      return IK::SD;
+      return leaf(IK::SD);
+    default:
+      return unknown();
+  }
+}
+
+constexpr DecodeSpec table_entry(DecodeTable table, OpcodeFields fields) {
+  switch (table) {
+    case DecodeTable::OP:
+      return op_entry(fields);
+    case DecodeTable::SPECIAL:
+      return special_entry(fields);
+    case DecodeTable::SYNC:
+      return sync_entry(fields);
+    case DecodeTable::REGIMM:
+      return regimm_entry(fields);
+    case DecodeTable::COP0:
+      return cop0_entry(fields);
+    case DecodeTable::MF0:
+      return mf0_entry(fields);
+    case DecodeTable::MT0:
+      return mt0_entry(fields);
+    case DecodeTable::C0:
+      return c0_entry(fields);
+    case DecodeTable::COP1:
+      return cop1_entry(fields);
+    case DecodeTable::BC1:
+      return bc1_entry(fields);
+    case DecodeTable::S:
+      return s_entry(fields);
+    case DecodeTable::W:
+      return w_entry(fields);
+    case DecodeTable::COP2:
+      return cop2_entry(fields);
+    case DecodeTable::COP2_MOVE:
+      return cop2_move_entry(fields);
+    case DecodeTable::MMI:
+      return mmi_entry(fields);
+    case DecodeTable::MMI0:
+      return mmi0_entry(fields);
+    case DecodeTable::MMI1:
+      return mmi1_entry(fields);
+    case DecodeTable::MMI2:
+      return mmi2_entry(fields);
+    case DecodeTable::MMI3:
+      return mmi3_entry(fields);
+    case DecodeTable::PMFHL:
+      return pmfhl_entry(fields);
+    case DecodeTable::CACHE:
+      return cache_entry(fields);
+    default:
+      return unknown();
+  }
+}
+
+constexpr int decode_table_entry_count() {
+  int count = 0;
+  for (int i = int(DecodeTable::OP); i < int(DecodeTable::COUNT); i++) {
+    count += table_index(DecodeTable(i)).mask + 1;
+  }
+  return count;
+}
+
+constexpr int DECODE_TABLE_ENTRIES = decode_table_entry_count();
+constexpr int MAX_DECODE_CHECKS = 64;
+
+static_assert(int(InstructionKind::EE_OP_MAX) <= UINT16_MAX, "InstructionKind must fit in 16 bits");
+
+// the checks of an entry. Stored separately as there are only a few different ones.
+struct DecodeChecks {
+  BitCheck check;
+  BitCheck match;
+};
+
+struct DecodeEntry {
+  uint16_t kind = 0;
+  DecodeTable next = DecodeTable::NONE;
+  uint8_t checks = 0;  // index into DecodeTables::checks
+};
+
+struct DecodeTables {
+  struct Table {
+    BitField index;
+    int offset;
+  };
+
+  Table tables[int(DecodeTable::COUNT)];
+  DecodeChecks checks[MAX_DECODE_CHECKS];
+  int check_count;
+  DecodeEntry entries[DECODE_TABLE_ENTRIES];
+};
+
+constexpr DecodeTables build_decode_tables() {
+  DecodeTables result{};
+  result.checks[0] = DecodeChecks();  // no checks
+  result.check_count = 1;
+
+  int offset = 0;
+  for (int i = int(DecodeTable::OP); i < int(DecodeTable::COUNT); i++) {
+    auto& table = result.tables[i];
+    table.index = table_index(DecodeTable(i));
+    table.offset = offset;
+
+    for (uint32_t idx = 0; idx <= table.index.mask; idx++) {
+      auto spec = table_entry(DecodeTable(i), OpcodeFields(idx << table.index.shift));
+      auto& entry = result.entries[offset + idx];
+      entry.kind = uint16_t(spec.kind);
+      entry.next = spec.next;
+
+      int check_idx = 0;
+      while (check_idx < result.check_count &&
+             !(result.checks[check_idx].check == spec.check &&
+               result.checks[check_idx].match == spec.match)) {
+        check_idx++;
+      }
+      if (check_idx == result.check_count) {
+        // too many is caught by the static_assert below.
+        if (check_idx < MAX_DECODE_CHECKS) {
+          result.checks[check_idx].check = spec.check;
+          result.checks[check_idx].match = spec.match;
+        }
+        result.check_count++;
+      }
+      entry.checks = uint8_t(check_idx);
+    }
+    offset += table.index.mask + 1;
+  }
+  return result;
+}
+
+constexpr DecodeTables gDecodeTables = build_decode_tables();
+static_assert(gDecodeTables.check_count <= MAX_DECODE_CHECKS, "too many decode checks");
+static_assert(gDecodeTables.tables[int(DecodeTable::OP)].offset == 0,
+              "decode_opcode expects OP to be the first table");
+
+/*!
+ * The bits of each FieldType used in OpcodeInfo decoding steps.
+ */
+constexpr BitField field_bits(FieldType field) {
+  switch (field) {
+    case FieldType::RS:
+      return RS_BITS;
+    case FieldType::RT:
+      return RT_BITS;
+    case FieldType::RD:
+      return RD_BITS;
+    case FieldType::FT:
+      return FT_BITS;
+    case FieldType::FS:
+      return FS_BITS;
+    case FieldType::FD:
+      return FD_BITS;
+    case FieldType::SIMM16:
+    case FieldType::ZIMM16:
+      return {0, 0xffff};
+    case FieldType::SA:
+      return SA_BITS;
+    case FieldType::SYSCALL:
+      return {6, 0xfffff};
+    case FieldType::PCR:
+      return {1, 0x1f};
+    case FieldType::DEST:
+      return DEST_BITS;
+    case FieldType::BC:
+      return {0, 0b11};
+    case FieldType::IMM5:
+      return {6, 0x1f};
+    case FieldType::IL:
+      return {0, 1};
+    case FieldType::IMM15:
+      return {6, 0b111111111111111};
+    case FieldType::ZERO:
     default:
-      return IK::UNKNOWN;
-      break;
+      return {0, 0};
+  }
+}
+
+struct FieldTable {
+  BitField fields[int(FieldType::ZERO) + 1];
+};
+
+constexpr FieldTable build_field_table() {
+  FieldTable result{};
+  for (int i = 0; i <= int(FieldType::ZERO); i++) {
+    result.fields[i] = field_bits(FieldType(i));
+  }
+  return result;
+}
+
+constexpr FieldTable gFieldTable = build_field_table();
+
+}  // namespace
+
+/*!
+ * Get the value of an operand field of an instruction.
+ */
+int32_t extract_field(uint32_t data, FieldType field) {
+  auto bits = gFieldTable.fields[int(field)];
+  uint32_t value = (data >> bits.shift) & bits.mask;
+  if (field == FieldType::SIMM16) {
+    return int16_t(value);
+  }
+  return int32_t(value);
+}
+
+/*!
+ * Decode the opcode of an instruction. Returns false if the instruction fails one of the checks
+ * that decode_instruction asserts, which means it isn't something we expect to find in real code.
+ */
+bool try_decode_opcode(uint32_t code, InstructionKind* kind) {
+  bool checks_ok = true;
+  const DecodeEntry* entry = &gDecodeTables.entries[code >> 26];
+  for (;;) {
+    auto& checks = gDecodeTables.checks[entry->checks];
+    if ((code & checks.match.mask) != checks.match.value) {
+      *kind = InstructionKind::UNKNOWN;
+      return checks_ok;
+    }
+    if ((code & checks.check.mask) != checks.check.value) {
+      checks_ok = false;
+    }
+
+    if (entry->next == DecodeTable::NONE) {
+      *kind = InstructionKind(entry->kind);
+      return checks_ok;
+    }
+    auto& table = gDecodeTables.tables[int(entry->next)];
+    entry = &gDecodeTables.entries[table.offset + ((code >> table.index.shift) & table.index.mask)];
   }
 }
 
+/*!
+ * Top level opcode decode
+ */
+static InstructionKind decode_opcode(uint32_t code) {
+  InstructionKind kind;
+  bool checks_ok = try_decode_opcode(code, &kind);
+  assert(checks_ok);
+  (void)checks_ok;
+  return kind;
+}
+
 /*!
  * Top level decode function.
  */
-Instruction decode_instruction(LinkedWord& word, LinkedObjectFile& file, int seg_id, int word_id) {
+Instruction decode_instruction(const LinkedWord& word, LinkedObjectFile& file, int seg_id, int word_id) {
   // determine the opcode, and get info for it
   Instruction i;
   auto op = decode_opcode(word.data);
@@ -1013,67 +1237,11 @@ Instruction decode_instruction(LinkedWord& word, LinkedObjectFile& file, int seg
     return i;
   }
   i.kind = op;
-  OpcodeFields fields(word.data);
 
   // loop through decoding steps to extract a value
   for (int j = 0; j < info.step_count; j++) {
     auto& step = info.steps[j];
-    int32_t value;
-    switch (step.field) {
-      case FieldType::RS:
-        value = fields.rs();
-        break;
-      case FieldType::RT:
-        value = fields.rt();
-        break;
-      case FieldType::RD:
-        value = fields.rd();
-        break;
-      case FieldType::FT:
-        value = fields.ft();
-        break;
-      case FieldType::FS:
-        value = fields.fs();
-        break;
-      case FieldType::FD:
-        value = fields.fd();
-        break;
-      case FieldType::SIMM16:
-        value = fields.simm16();
-        break;
-      case FieldType::ZIMM16:
-        value = fields.zimm16();
-        break;
-      case FieldType::SA:
-        value = fields.sa();
-        break;
-      case FieldType::SYSCALL:
-        value = fields.syscall();
-        break;
-      case FieldType::PCR:
-        value = fields.pcreg();
-        break;
-      case FieldType::DEST:
-        value = fields.dest();
-        break;
-      case FieldType::BC:
-        value = fields.data & 0b11;
-        break;
-      case FieldType::IMM5:
-        value = fields.imm5();
-        break;
-      case FieldType::IL:
-        value = fields.data & 1;
-        break;
-      case FieldType::IMM15:
-        value = fields.imm15();
-        break;
-      case FieldType::ZERO:
-        value = 0;
-        break;
-      default:
-        assert(false);
-    }
+    int32_t value = extract_field(word.data, step.field);
 
     // use the value, to possibly add an atom
     InstructionAtom atom;
@@ -1134,36 +1302,36 @@ Instruction decode_instruction(LinkedWord& word, LinkedObjectFile& file, int seg
     }
   }
 
-  if (word.kind == LinkedWord::SYM_OFFSET) {
+  if (word.kind() == LinkedWord::SYM_OFFSET) {
     bool fixed = false;
     for (int j = 0; j < i.n_src; j++) {
       if (i.src[j].kind == InstructionAtom::IMM) {
         fixed = true;
-        i.src[j].set_sym(word.symbol_name);
+        i.src[j].set_sym(word.symbol_id());
       }
     }
     assert(fixed);
   }
 
-  if (word.kind == LinkedWord::HI_PTR) {
+  if (word.kind() == LinkedWord::HI_PTR) {
     assert(i.kind == InstructionKind::LUI);
     bool fixed = false;
     for (int j = 0; j < i.n_src; j++) {
       if (i.src[j].kind == InstructionAtom::IMM) {
         fixed = true;
-        i.src[j].set_label(word.label_id);
+        i.src[j].set_label(word.label_id());
       }
     }
     assert(fixed);
   }
 
-  if (word.kind == LinkedWord::LO_PTR) {
+  if (word.kind() == LinkedWord::LO_PTR) {
     assert(i.kind == InstructionKind::ORI);
     bool fixed = false;
     for (int j = 0; j < i.n_src; j++) {
       if (i.src[j].kind == InstructionAtom::IMM) {
         fixed = true;
-        i.src[j].set_label(word.label_id);
+        i.src[j].set_label(word.label_id());
       }
     }
     assert(fixed);
@@ -12,6 +12,15 @@
 class LinkedWord;
 class LinkedObjectFile;
 
-Instruction decode_instruction(LinkedWord& word, LinkedObjectFile& file, int seg_id, int word_id);
+// Bump this when decode_instruction changes its output, so cached disassembly is thrown out.
+constexpr uint32_t DECODER_VERSION = 1;
+
+bool try_decode_opcode(uint32_t code, InstructionKind* kind);
+int32_t extract_field(uint32_t data, FieldType field);
+Instruction decode_instruction(const LinkedWord& word, LinkedObjectFile& file, int seg_id, int word_id);
+
+// the original decoder, to check the one above against (see InstructionDecodeReference.cpp)
+bool try_decode_opcode_reference(uint32_t code, InstructionKind* kind);
+int32_t extract_field_reference(uint32_t data, FieldType field);
 
 #endif  // NEXT_INSTRUCTIONDECODE_H
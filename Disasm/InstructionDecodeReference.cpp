@@ -0,0 +1,1087 @@
+/*!
+ * @file InstructionDecodeReference.cpp
+ * The original switch based opcode decoder and field extraction, kept as a reference for the table
+ * driven decoder in InstructionDecode.cpp. Only used by the full decoder sweep, which checks that
+ * the two agree on every 32-bit word.
+ */
+
+#include "InstructionDecode.h"
+
+namespace {
+// the original decoder asserted on these. Here a failed check is only recorded, so the sweep can
+// compare which words fail.
+thread_local bool t_check_failed = false;
+
+void check(bool ok) {
+  if (!ok) {
+    t_check_failed = true;
+  }
+}
+
+// utility class to extract fields of an opcode.
+struct OpcodeFields {
+  OpcodeFields(uint32_t _data) : data(_data) {}
+
+  // 26 - 31
+  uint32_t op() { return (data >> 26); }
+
+  //////////////
+  // R - Type //
+  //////////////
+
+  // 21 - 25
+  uint32_t rs() { return (data >> 21) & 0x1f; }
+
+  // 16 - 20
+  uint32_t rt() { return (data >> 16) & 0x1f; }
+
+  // 11 - 15
+  uint32_t rd() { return (data >> 11) & 0x1f; }
+
+  //  6 - 10
+  uint32_t sa() { return (data >> 6) & 0x1f; }
+
+  // 0 - 5
+  uint32_t function() { return (data)&0x3f; }
+
+  ////////////////
+  // Immediates //
+  ////////////////
+
+  int32_t simm16() { return (int16_t)(data); }
+
+  int32_t zimm16() { return (uint16_t)(data); }
+
+  uint32_t imm5() { return (data >> 6) & 0x1f; }
+
+  uint32_t imm15() { return (data >> 6) & 0b111111111111111; }
+
+  ////////////////////
+  // Floating Point //
+  ////////////////////
+
+  uint32_t cop_func() { return (data >> 21) & 0x1f; }
+
+  uint32_t ft() { return (data >> 16) & 0x1f; }
+
+  uint32_t fs() { return (data >> 11) & 0x1f; }
+
+  uint32_t fd() { return (data >> 6) & 0x1f; }
+
+  ////////////
+  // Others //
+  ////////////
+
+  uint32_t pcreg() { return (data >> 1) & 0x1f; }
+
+  uint32_t syscall() { return (data >> 6) & 0xfffff; }
+
+  uint32_t MMI_func() { return (data >> 6) & 0x1f; }
+
+  uint32_t lower11() { return (uint32_t)(data & 0x7ff); }
+
+  uint32_t lower6() { return (uint32_t)(data & 0b111111); }
+
+  uint32_t dest() { return (data >> 21) & 0b1111; }
+
+  uint32_t data;
+};
+
+//////////////////
+// OPCODE DECODE
+//////////////////
+
+InstructionKind decode_cop2(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  switch (fields.lower11()) {
+    case 0b0:
+    case 0b1:
+      switch (fields.cop_func()) {
+        case 0b00001:
+          return IK::QMFC2;
+
+        case 0b00101:
+          check(((fields.data >> 1) & (0b1111111111)) == 0);
+          return IK::QMTC2;
+
+        case 0b00010:
+          return IK::CFC2;
+
+        case 0b00110:
+          return IK::CTC2;
+
+        default:
+          return IK::UNKNOWN;
+      }
+      break;
+
+    case 0b00010111100:
+    case 0b00010111101:
+    case 0b00010111110:
+    case 0b00010111111:
+      check(fields.data & (1 << 25));
+      return IK::VMADDA_BC;
+
+    case 0b00000111100:
+    case 0b00000111101:
+    case 0b00000111110:
+    case 0b00000111111:
+      check(fields.data & (1 << 25));
+      return IK::VADDA_BC;
+
+    case 0b00110111100:
+    case 0b00110111101:
+    case 0b00110111110:
+    case 0b00110111111:
+      check(fields.data & (1 << 25));
+      return IK::VMULA_BC;
+
+    case 0b01010111110:
+      check(fields.data & (1 << 25));
+      return IK::VMULA;
+
+    case 0b01010111100:
+      check(fields.data & (1 << 25));
+      return IK::VADDA;
+
+    case 0b01010111101:
+      check(fields.data & (1 << 25));
+      return IK::VMADDA;
+
+    case 0b00011111100:
+    case 0b00011111101:
+    case 0b00011111110:
+    case 0b00011111111:
+      check(fields.data & (1 << 25));
+      return IK::VMSUBA_BC;
+
+    case 0b00101111100:
+      check(fields.data & (1 << 25));
+      return IK::VFTOI0;
+
+    case 0b00101111101:
+      check(fields.data & (1 << 25));
+      return IK::VFTOI4;
+
+    case 0b00101111110:
+      check(fields.data & (1 << 25));
+      return IK::VFTOI12;
+
+    case 0b00100111100:
+      check(fields.data & (1 << 25));
+      return IK::VITOF0;
+
+    case 0b00100111110:
+      check(fields.data & (1 << 25));
+      return IK::VITOF12;
+
+    case 0b00100111111:
+      check(fields.data & (1 << 25));
+      return IK::VITOF15;
+
+    case 0b00111111100:
+      check(fields.data & (1 << 25));
+      check(fields.ft() == 0);
+      return IK::VMULAQ;
+
+    case 0b00111111101:
+      check(fields.data & (1 << 25));
+      return IK::VABS;
+
+    case 0b00111111111:
+      check(fields.data & (1 << 25));
+      check(fields.dest() == 0b1110);
+      return IK::VCLIP;
+
+    case 0b01011111111:
+      check(fields.dest() == 0);
+      check(fields.ft() == 0);
+      check(fields.fs() == 0);
+      return IK::VNOP;
+    case 0b01101111101:
+      check(fields.data & (1 << 25));
+      return IK::VSQI;
+    case 0b01101111100:
+      check(fields.data & (1 << 25));
+      return IK::VLQI;
+    case 0b01110111111:
+      check(fields.dest() == 0);
+      check(fields.ft() == 0);
+      check(fields.fs() == 0);
+      return IK::VWAITQ;
+
+    case 0b01011111110:
+      check(fields.dest() == 0b1110);
+      check(fields.data & (1 << 25));
+      return IK::VOPMULA;
+
+    case 0b01100111100:
+      check(fields.data & (1 << 25));
+      return IK::VMOVE;
+
+    case 0b01110111100:
+      check(fields.data & (1 << 25));
+      return IK::VDIV;
+
+    case 0b01110111101:
+      check(fields.fs() == 0);
+      check(((fields.data >> 21) & 3) == 0);
+      check(fields.data & (1 << 25));
+      return IK::VSQRT;
+
+    case 0b01111111100:
+      check(((fields.data >> 23) & 3) == 0);
+      check(fields.data & (1 << 25));
+      return IK::VMTIR;
+
+    case 0b01110111110:
+      check(fields.data & (1 << 25));
+      return IK::VRSQRT;
+
+    case 0b10000111100:
+      check(fields.fs() == 0);
+      check(fields.data & (1 << 25));
+      return IK::VRNEXT;
+
+    case 0b10000111101:
+      check(fields.fs() == 0);
+      check(fields.data & (1 << 25));
+      return IK::VRGET;
+
+    case 0b10000111111:
+      check(fields.ft() == 0);
+      check(fields.data & (1 << 25));
+      check(((fields.data >> 23) & 3) == 0);
+      return IK::VRXOR;
+    default:
+
+      switch (fields.lower6()) {
+        case 0b000000:
+        case 0b000001:
+        case 0b000010:
+        case 0b000011:
+          check(fields.data & (1 << 25));
+          return IK::VADD_BC;
+
+        case 0b000100:
+        case 0b000101:
+        case 0b000110:
+        case 0b000111:
+          check(fields.data & (1 << 25));
+          return IK::VSUB_BC;
+
+        case 0b001000:
+        case 0b001001:
+        case 0b001010:
+        case 0b001011:
+          check(fields.data & (1 << 25));
+          return IK::VMADD_BC;
+
+        case 0b001100:
+        case 0b001101:
+        case 0b001110:
+        case 0b001111:
+          check(fields.data & (1 << 25));
+          return IK::VMSUB_BC;
+
+        case 0b010000:
+        case 0b010001:
+        case 0b010010:
+        case 0b010011:
+          check(fields.data & (1 << 25));
+          return IK::VMAX_BC;
+
+        case 0b010100:
+        case 0b010101:
+        case 0b010110:
+        case 0b010111:
+          check(fields.data & (1 << 25));
+          return IK::VMINI_BC;
+
+        case 0b011000:
+        case 0b011001:
+        case 0b011010:
+        case 0b011011:
+          check(fields.data & (1 << 25));
+          return IK::VMUL_BC;
+
+        case 0b011100:
+          check(fields.ft() == 0);
+          check(fields.data & (1 << 25));
+          return IK::VMULQ;
+
+        case 0b100000:
+          check(fields.data & (1 << 25));
+          return IK::VADDQ;
+
+        case 0b100100:
+          check(fields.data & (1 << 25));
+          return IK::VSUBQ;
+
+        case 0b100101:
+          check(fields.ft() == 0);
+          check(fields.data & (1 << 25));
+          return IK::VMSUBQ;
+
+        case 0b101000:
+          check(fields.data & (1 << 25));
+          return IK::VADD;
+        case 0b101001:
+          check(fields.data & (1 << 25));
+          return IK::VMADD;
+        case 0b101010:
+          check(fields.data & (1 << 25));
+          return IK::VMUL;
+        case 0b101011:
+          check(fields.data & (1 << 25));
+          return IK::VMAX;
+        case 0b101100:
+          check(fields.data & (1 << 25));
+          return IK::VSUB;
+        case 0b101101:
+          check(fields.data & (1 << 25));
+          return IK::VMSUB;
+        case 0b101110:
+          check(fields.data & (1 << 25));
+          check(fields.dest() == 0b1110);
+          return IK::VOPMSUB;
+        case 0b101111:
+          check(fields.data & (1 << 25));
+          return IK::VMINI;
+        case 0b110010:
+          check(fields.data & (1 << 25));
+          check(fields.dest() == 0b0);
+          return IK::VIADDI;
+        case 0b110100:
+          check(fields.data & (1 << 25));
+          check(fields.dest() == 0b0);
+          return IK::VIAND;
+        case 0b111000:
+          check(fields.data & (1 << 25));
+          check(fields.dest() == 0b0);
+          return IK::VCALLMS;
+        default:
+          return IK::UNKNOWN;
+      }
+  }
+}
+
+InstructionKind decode_W(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  switch (fields.function()) {
+    case 0b100000:
+      check(fields.ft() == 0);
+      return IK::CVTSW;
+    default:
+      return IK::UNKNOWN;
+  }
+}
+
+InstructionKind decode_S(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  switch (fields.function()) {
+    case 0b000000:
+      return IK::ADDS;
+    case 0b000001:
+      return IK::SUBS;
+    case 0b000010:
+      return IK::MULS;
+    case 0b000011:
+      return IK::DIVS;
+    case 0b000101:
+      return IK::ABSS;
+    case 0b000110:
+      check(fields.ft() == 0);
+      return IK::MOVS;
+    case 0b000111:
+      check(fields.ft() == 0);
+      return IK::NEGS;
+    case 0b000100:
+      check(fields.fs() == 0);
+      return IK::SQRTS;
+    case 0b010110:
+      return IK::RSQRTS;
+    case 0b011000:
+      check(fields.fd() == 0);
+      return IK::ADDAS;
+    case 0b011010:
+      check(fields.fd() == 0);
+      return IK::MULAS;
+    case 0b011100:
+      return IK::MADDS;
+    case 0b011101:
+      return IK::MSUBS;
+    case 0b011110:
+      check(fields.fd() == 0);
+      return IK::MADDAS;
+    case 0b011111:
+      check(fields.fd() == 0);
+      return IK::MSUBAS;
+    case 0b100100:
+      check(fields.ft() == 0);
+      return IK::CVTWS;
+    case 0b101000:
+      return IK::MAXS;
+    case 0b101001:
+      return IK::MINS;
+    case 0b110010:
+      check(fields.fd() == 0);
+      return IK::CEQS;
+    case 0b110100:
+      check(fields.fd() == 0);
+      return IK::CLTS;
+    case 0b110110:
+      check(fields.fd() == 0);
+      return IK::CLES;
+    default:
+      return IK::UNKNOWN;
+  }
+}
+
+InstructionKind decode_BC1(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  switch (fields.ft()) {
+    case 0b00000:
+      return IK::BC1F;
+    case 0b00001:
+      return IK::BC1T;
+    case 0b00010:
+      return IK::BC1FL;
+    case 0b00011:
+      return IK::BC1TL;
+    default:
+      return IK::UNKNOWN;
+  }
+}
+
+InstructionKind decode_cop1(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  switch (fields.cop_func()) {
+    case 0b00000:
+      check(fields.sa() == 0);
+      check(fields.function() == 0);
+      return IK::MFC1;
+    case 0b00100:
+      check(fields.sa() == 0);
+      check(fields.function() == 0);
+      return IK::MTC1;
+    case 0b01000:
+      return decode_BC1(fields);
+    case 0b10000:
+      return decode_S(fields);
+    case 0b10100:
+      return decode_W(fields);
+    default:
+      return IK::UNKNOWN;
+  }
+}
+
+InstructionKind decode_c0(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  switch (fields.function()) {
+    case 0b011000:
+      return IK::ERET;
+    case 0b111000:
+      check(fields.sa() == 0 && fields.rd() == 0 && fields.rt() == 0);
+      return IK::EI;
+    default:
+      return IK::UNKNOWN;
+  }
+}
+
+InstructionKind decode_mt0(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  switch (fields.lower11()) {
+    case 0b00000000000:
+      return IK::MTC0;
+    case 0b00000000100:
+      check(fields.rd() == 0b11000);
+      return IK::MTDAB;
+    case 0b00000000101:
+      check(fields.rd() == 0b11000);
+      return IK::MTDABM;
+    default:
+      if (fields.rd() == 0b11001 && fields.sa() == 0 && (fields.data & 1) == 1) {
+        return IK::MTPC;
+      } else {
+        return IK::UNKNOWN;
+      }
+  }
+}
+
+InstructionKind decode_mf0(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  switch (fields.lower11()) {
+    case 0b0:
+      return IK::MFC0;
+    default:
+      if (fields.rd() == 0b11001 && fields.sa() == 0 && (fields.data & 1) == 1) {
+        return IK::MFPC;
+      } else {
+        return IK::UNKNOWN;
+      }
+  }
+}
+
+InstructionKind decode_cop0(OpcodeFields fields) {
+  switch (fields.cop_func()) {
+    case 0b00000:
+      return decode_mf0(fields);
+    case 0b00100:
+      return decode_mt0(fields);
+    case 0b10000:
+      return decode_c0(fields);
+    default:
+      return InstructionKind::UNKNOWN;
+  }
+}
+
+InstructionKind decode_mmi3(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  switch (fields.MMI_func()) {
+    case 0b01010:
+      return IK::PINTEH;
+    case 0b01110:
+      return IK::PCPYUD;
+    case 0b10010:
+      return IK::POR;
+    case 0b10011:
+      return IK::PNOR;
+    case 0b11011:
+      check(fields.rs() == 0);
+      return IK::PCPYH;
+    default:
+      return IK::UNKNOWN;
+  }
+}
+
+InstructionKind decode_mmi2(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  switch (fields.MMI_func()) {
+    case 0b01110:
+      return IK::PCPYLD;
+    case 0b10000:
+      return IK::PMADDH;
+    case 0b10010:
+      return IK::PAND;
+    case 0b11100:
+      return IK::PMULTH;
+    case 0b11110:
+      return IK::PEXEW;
+    case 0b11111:
+      return IK::PROT3W;
+    default:
+      return IK::UNKNOWN;
+  }
+}
+
+InstructionKind decode_mmi1(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  switch (fields.MMI_func()) {
+    case 0b00001:
+      return IK::PABSW;
+    case 0b00010:
+      return IK::PCEQW;
+    case 0b00011:
+      return IK::PMINW;
+    case 0b00111:
+      return IK::PMINH;
+    case 0b01010:
+      return IK::PCEQB;
+    case 0b10010:
+      return IK::PEXTUW;
+    case 0b10110:
+      return IK::PEXTUH;
+    case 0b11010:
+      return IK::PEXTUB;
+    default:
+      return IK::UNKNOWN;
+  }
+}
+
+InstructionKind decode_mmi0(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  switch (fields.MMI_func()) {
+    case 0b00000:
+      return IK::PADDW;
+    case 0b00001:
+      return IK::PSUBW;
+    case 0b00010:
+      return IK::PCGTW;
+    case 0b00011:
+      return IK::PMAXW;
+    case 0b00100:
+      return IK::PADDH;
+    case 0b00111:
+      return IK::PMAXH;
+    case 0b10010:
+      return IK::PEXTLW;
+    case 0b10011:
+      return IK::PPACW;
+    case 0b10111:
+      return IK::PPACH;
+    case 0b10110:
+      return IK::PEXTLH;
+    case 0b11010:
+      return IK::PEXTLB;
+    case 0b11011:
+      return IK::PPACB;
+    default:
+      return IK::UNKNOWN;
+  }
+}
+
+InstructionKind decode_pmfhl(OpcodeFields fields) {
+  // the PMFHL instruction is split into several types, and we create different instructions for
+  // each.
+  typedef InstructionKind IK;
+  switch (fields.sa()) {
+    case 0b00001:
+      check(fields.rs() == 0);
+      check(fields.rt() == 0);
+      return IK::PMFHL_UW;
+    case 0b00000:
+      check(fields.rs() == 0);
+      check(fields.rt() == 0);
+      return IK::PMFHL_LW;
+    case 0b00011:
+      check(fields.rs() == 0);
+      check(fields.rt() == 0);
+      return IK::PMFHL_LH;
+    default:
+      return IK::UNKNOWN;
+  }
+}
+
+InstructionKind decode_mmi(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  switch (fields.function()) {
+    case 0b000100:
+      check(fields.sa() == 0);
+      check(fields.rt() == 0);
+      return IK::PLZCW;
+    case 0b001000:
+      return decode_mmi0(fields);
+    case 0b001001:
+      return decode_mmi2(fields);
+
+    case 0b010011:
+      check(fields.sa() == 0);
+      check(fields.rd() == 0);
+      check(fields.rt() == 0);
+      return IK::MTLO1;
+    case 0b010010:
+      check(fields.sa() == 0);
+      check(fields.rs() == 0);
+      check(fields.rt() == 0);
+      return IK::MFLO1;
+
+    case 0b101000:
+      return decode_mmi1(fields);
+    case 0b101001:
+      return decode_mmi3(fields);
+    case 0b110000:
+      return decode_pmfhl(fields);
+    case 0b110100:
+      return IK::PSLLH;
+    case 0b110110:
+      return IK::PSRLH;
+    case 0b110111:
+      return IK::PSRAH;
+    case 0b111100:
+      return IK::PSLLW;
+    case 0b111111:
+      return IK::PSRAW;
+    default:
+      return IK::UNKNOWN;
+  }
+}
+
+InstructionKind decode_regimm(OpcodeFields files) {
+  typedef InstructionKind IK;
+  switch (files.rt()) {
+    case 0b00000:
+      return IK::BLTZ;
+    case 0b00001:
+      return IK::BGEZ;
+    case 0b00010:
+      return IK::BLTZL;
+    case 0b00011:
+      return IK::BGEZL;
+    case 0b10001:
+      return IK::BGEZAL;
+    default:
+      return IK::UNKNOWN;
+  }
+}
+
+InstructionKind decode_sync(OpcodeFields fields) {
+  // the "sync" opcode has a "stype" field which picks between P and L type syncs.
+  // to avoid implementing this, we just split SYNC into two separate instructions.
+  typedef InstructionKind IK;
+  auto stype = fields.sa();
+  check(fields.rt() == 0);
+  check(fields.rs() == 0);
+  check(fields.rd() == 0);
+  if (stype == 0b00000) {
+    return IK::SYNCL;
+  } else if (stype == 0b10000) {
+    return IK::SYNCP;
+  } else {
+    return IK::UNKNOWN;
+  }
+}
+
+InstructionKind decode_special(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  switch (fields.function()) {
+    case 0b000000:
+      check(fields.rs() == 0);
+      return IK::SLL;
+    // RESERVED
+    case 0b000010:
+      check(fields.rs() == 0);
+      return IK::SRL;
+    case 0b000011:
+      check(fields.rs() == 0);
+      return IK::SRA;
+    case 0b000100:
+      check(fields.sa() == 0);
+      return IK::SLLV;
+    // RESERVED
+    // SRLV
+    // SRAV
+    case 0b001000:
+      check(fields.sa() == 0);
+      check(fields.rd() == 0);
+      check(fields.rt() == 0);
+      return IK::JR;
+    case 0b001001:
+      check(fields.rt() == 0);
+      check(fields.sa() == 0);
+      return IK::JALR;
+    case 0b001010:
+      check(fields.sa() == 0);
+      return IK::MOVZ;
+    case 0b001011:
+      check(fields.sa() == 0);
+      return IK::MOVN;
+    case 0b001100:
+      return IK::SYSCALL;
+    // BREAK
+    // RESERVED
+    case 0b001111:
+      return decode_sync(fields);
+
+    case 0b010000:
+      check(fields.rs() == 0);
+      check(fields.rt() == 0);
+      check(fields.sa() == 0);
+      return IK::MFHI;
+    // MTHI
+    case 0b010010:
+      check(fields.rs() == 0);
+      check(fields.rt() == 0);
+      check(fields.sa() == 0);
+      return IK::MFLO;
+    // MTLO
+    case 0b010100:
+      check(fields.sa() == 0);
+      return IK::DSLLV;
+    // RESERVED
+    case 0b010110:
+      check(fields.sa() == 0);
+      return IK::DSRLV;
+    case 0b010111:
+      check(fields.sa() == 0);
+      return IK::DSRAV;
+    case 0b011000:
+      check(fields.sa() == 0);
+      return IK::MULT3;
+    case 0b011001:
+      check(fields.sa() == 0);
+      return IK::MULTU3;
+    case 0b011010:
+      check(fields.sa() == 0);
+      check(fields.rd() == 0);
+      return IK::DIV;
+    case 0b011011:
+      check(fields.sa() == 0);
+      check(fields.rd() == 0);
+      return IK::DIVU;
+    // 4x UNSUPPORTED
+    // ADD
+    case 0b100001:
+      check(fields.sa() == 0);
+      return IK::ADDU;
+    // SUB
+    case 0b100011:
+      check(fields.sa() == 0);
+      return IK::SUBU;
+    case 0b100100:
+      check(fields.sa() == 0);
+      return IK::AND;
+    case 0b100101:
+      check(fields.sa() == 0);
+      return IK::OR;
+    case 0b100110:
+      check(fields.sa() == 0);
+      return IK::XOR;
+    case 0b100111:
+      check(fields.sa() == 0);
+      return IK::NOR;
+    // MFSA
+    // MTSA
+    case 0b101010:
+      check(fields.sa() == 0);
+      return IK::SLT;
+    case 0b101011:
+      check(fields.sa() == 0);
+      return IK::SLTU;
+    // DADD
+    case 0b101101:
+      return IK::DADDU;
+    // DSUB
+    case 0b101111:
+      return IK::DSUBU;
+    // TGE
+    // TGEU
+    // TLT
+    // TLTU
+    // TEQ
+    // RESERVED
+    // TNE
+    // RESERVED
+    case 0b111000:
+      check(fields.rs() == 0);
+      return IK::DSLL;
+    // RESERVED
+    case 0b111010:
+      check(fields.rs() == 0);
+      return IK::DSRL;
+    case 0b111011:
+      check(fields.rs() == 0);
+      return IK::DSRA;
+    case 0b111100:
+      check(fields.rs() == 0);
+      return IK::DSLL32;
+    // RESERVED
+    case 0b111110:
+      check(fields.rs() == 0);
+      return IK::DSRL32;
+    case 0b111111:
+      check(fields.rs() == 0);
+      return IK::DSRA32;
+    default:
+      return IK::UNKNOWN;
+  }
+}
+
+InstructionKind decode_cache(OpcodeFields fields) {
+  typedef InstructionKind IK;
+  // there's only one cache instruction used (DXWBIN), so we just use a CACHE DXWBIN instruction
+  // to avoid having to implement the full cache instruction decoding.
+  switch (fields.rt()) {
+    case 0b10100:
+      return IK::CACHE_DXWBIN;
+    default:
+      return IK::UNKNOWN;
+  }
+}
+
+/*!
+ * Top level opcode decode
+ */
+InstructionKind decode_opcode(uint32_t code) {
+  OpcodeFields fields(code);
+  typedef InstructionKind IK;
+  switch (fields.op()) {
+    case 0b000000:
+      return decode_special(fields);
+    case 0b000001:
+      return decode_regimm(fields);
+    // J      010
+    // JAL    011
+    case 0b000100:
+      return IK::BEQ;
+    case 0b000101:
+      return IK::BNE;
+    case 0b000110:
+      return IK::BLEZ;
+    case 0b000111:
+      return IK::BGTZ;
+    // ADDI  1000
+    case 0b001001:
+      return IK::ADDIU;
+    case 0b001010:
+      return IK::SLTI;
+    case 0b001011:
+      return IK::SLTIU;
+    case 0b001100:
+      return IK::ANDI;
+    case 0b001101:
+      return IK::ORI;
+    case 0b001110:
+      return IK::XORI;
+    case 0b001111:
+      check(fields.rs() == 0);
+      return IK::LUI;
+    case 0b010000:
+      return decode_cop0(fields);
+    case 0b010001:
+      return decode_cop1(fields);
+    case 0b010010:
+      return decode_cop2(fields);
+    //     010011:
+    //  reserved
+    case 0b010100:
+      return IK::BEQL;
+    case 0b010101:
+      return IK::BNEL;
+    //     010110
+    //  blezl
+    case 0b010111:
+      check(fields.rt() == 0);
+      return IK::BGTZL;
+    //   0b011000:
+    //  daddi
+    case 0b011001:
+      return IK::DADDIU;
+    case 0b011010:
+      return IK::LDL;
+    case 0b011011:
+      return IK::LDR;
+    case 0b011100:
+      return decode_mmi(fields);
+    //   0b011101:
+    // reserved
+    case 0b011110:
+      return IK::LQ;
+    case 0b011111:
+      return IK::SQ;
+    case 0b100000:
+      return IK::LB;
+    case 0b100001:
+      return IK::LH;
+    case 0b100010:
+      return IK::LWL;
+    case 0b100011:
+      return IK::LW;
+    case 0b100100:
+      return IK::LBU;
+    case 0b100101:
+      return IK::LHU;
+    case 0b100110:
+      return IK::LWR;
+    case 0b100111:
+      return IK::LWU;
+    case 0b101000:
+      return IK::SB;
+    case 0b101001:
+      return IK::SH;
+    case 0b101011:
+      return IK::SW;
+    // SDL
+    // SDR
+    // SWR
+    case 0b101111:
+      return decode_cache(fields);
+
+    // unsupported
+    case 0b110001:
+      return IK::LWC1;
+    // unsupported
+    case 0b110011:
+      return IK::PREF;
+    // unsupported
+    // unsupported
+    case 0b110110:
+      return IK::LQC2;
+    case 0b110111:
+      return IK::LD;
+    case 0b111001:
+      return IK::SWC1;
+    case 0b111110:
+      return IK::SQC2;
+    case 0b111111:
+      return IK::SD;
+    default:
+      return IK::UNKNOWN;
+      break;
+  }
+}
+}  // namespace
+
+/*!
+ * Decode the opcode of an instruction with the original decoder. Returns false if the instruction
+ * fails one of the checks that the original decoder asserted.
+ */
+bool try_decode_opcode_reference(uint32_t code, InstructionKind* kind) {
+  t_check_failed = false;
+  *kind = decode_opcode(code);
+  return !t_check_failed;
+}
+
+/*!
+ * Get the value of an operand field with the original field extraction.
+ */
+int32_t extract_field_reference(uint32_t data, FieldType field) {
+  OpcodeFields fields(data);
+  int32_t value = 0;
+  switch (field) {
+    case FieldType::RS:
+      value = fields.rs();
+      break;
+    case FieldType::RT:
+      value = fields.rt();
+      break;
+    case FieldType::RD:
+      value = fields.rd();
+      break;
+    case FieldType::FT:
+      value = fields.ft();
+      break;
+    case FieldType::FS:
+      value = fields.fs();
+      break;
+    case FieldType::FD:
+      value = fields.fd();
+      break;
+    case FieldType::SIMM16:
+      value = fields.simm16();
+      break;
+    case FieldType::ZIMM16:
+      value = fields.zimm16();
+      break;
+    case FieldType::SA:
+      value = fields.sa();
+      break;
+    case FieldType::SYSCALL:
+      value = fields.syscall();
+      break;
+    case FieldType::PCR:
+      value = fields.pcreg();
+      break;
+    case FieldType::DEST:
+      value = fields.dest();
+      break;
+    case FieldType::BC:
+      value = fields.data & 0b11;
+      break;
+    case FieldType::IMM5:
+      value = fields.imm5();
+      break;
+    case FieldType::IL:
+      value = fields.data & 1;
+      break;
+    case FieldType::IMM15:
+      value = fields.imm15();
+      break;
+    case FieldType::ZERO:
+      value = 0;
+      break;
+    default:
+      check(false);
+  }
+  return value;
+}
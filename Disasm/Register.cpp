@@ -108,6 +108,19 @@ Register::Register(Reg::RegisterKind kind, uint32_t num) {
   }
 }
 
+/*!
+ * Get the 16-bit id of this register, for storing it somewhere compact. from_id converts it back.
+ */
+uint16_t Register::to_id() const {
+  return id;
+}
+
+Register Register::from_id(uint16_t id) {
+  Register result;
+  result.id = id;
+  return result;
+}
+
 /*!
  * Convert to string. The register must be valid.
  */
@@ -135,6 +135,9 @@ class Register {
   Reg::Cop0 get_cop0() const;
   uint32_t get_pcr() const;
 
+  uint16_t to_id() const;
+  static Register from_id(uint16_t id);
+
   bool operator==(const Register& other) const;
   bool operator!=(const Register& other) const;
 
@@ -411,7 +411,7 @@ void Function::check_epilogue(const LinkedObjectFile& file) {
  *
  * Updates the guessed_name of the function and updates type_info
  */
-void Function::find_global_function_defs(LinkedObjectFile& file) {
+void Function::find_global_function_defs(LinkedObjectFile& file, TypeInfo& type_info) {
   for (auto& block : basic_blocks) {
     int label_id = -1;
     Register reg;
@@ -447,14 +447,14 @@ void Function::find_global_function_defs(LinkedObjectFile& file) {
         if (instr.kind == InstructionKind::SW && instr.get_src(0).get_reg() == reg &&
             instr.get_src(2).get_reg() == make_gpr(Reg::S7)) {
           // done!
-          std::string name = instr.get_src(1).get_sym();
+          std::string name = instr.get_src(1).get_sym(file);
           if(!file.label_points_to_code(label_id)) {
 //            printf("discard as not code: %s\n", name.c_str());
           } else {
             auto& func = file.get_function_at_label(label_id);
             assert(func.guessed_name.empty());
             func.guessed_name = name;
-            get_type_info().inform_symbol(name, TypeSpec("function"));
+            type_info.inform_symbol(name, TypeSpec("function"));
             // todo - inform function.
           }
 
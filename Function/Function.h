@@ -6,11 +6,13 @@
 #include "Disasm/Instruction.h"
 #include "BasicBlocks.h"
 
+class TypeInfo;
+
 class Function {
  public:
   Function(int _start_word, int _end_word);
   void analyze_prologue(const LinkedObjectFile& file);
-  void find_global_function_defs(LinkedObjectFile& file);
+  void find_global_function_defs(LinkedObjectFile& file, TypeInfo& type_info);
 
   int segment = -1;
   int start_word = -1;
@@ -20,7 +22,12 @@ class Function {
 
   bool suspected_asm = false;
 
+  // filled in by LinkedObjectFile::disassemble_function when first needed. release_instructions
+  // frees them, and they are decoded again if needed later.
   std::vector<Instruction> instructions;
+  bool disassembled = false;           // instructions are decoded right now
+  bool instructions_released = false;  // decoded before, then freed by release_instructions
+  bool fp_links_done = false;          // fp-relative links were resolved, redo them when decoding
   std::vector<BasicBlock> basic_blocks;
 
   int prologue_start = -1;
@@ -7,8 +7,12 @@
 #include <cassert>
 #include <cstring>
 #include <numeric>
+#include <type_traits>
 #include "Disasm/InstructionDecode.h"
 #include "config.h"
+#include "util/BinaryReader.h"
+#include "util/BinaryWriter.h"
+#include "util/BufferedFileWriter.h"
 
 /*!
  * Set the number of segments in this object file.
@@ -24,10 +28,19 @@ void LinkedObjectFile::set_segment_count(int n_segs) {
 }
 
 /*!
- * Add a single word to the given segment.
+ * Set all the words of the given segment at once.
  */
-void LinkedObjectFile::push_back_word_to_segment(uint32_t word, int segment) {
-  words_by_seg.at(segment).emplace_back(word);
+void LinkedObjectFile::set_segment_words(int segment, const uint8_t* data, size_t word_count) {
+  words_by_seg.at(segment).assign(data, word_count);
+}
+
+/*!
+ * Call after all links have been added, to compact the link info.
+ */
+void LinkedObjectFile::finish_linking() {
+  for (auto& words : words_by_seg) {
+    words.finish_linking();
+  }
 }
 
 /*!
@@ -35,24 +48,30 @@ void LinkedObjectFile::push_back_word_to_segment(uint32_t word, int segment) {
  * Will return an existing label if one exists.
  */
 int LinkedObjectFile::get_label_id_for(int seg, int offset) {
-  auto kv = label_per_seg_by_offset.at(seg).find(offset);
-  if (kv == label_per_seg_by_offset.at(seg).end()) {
-    // create a new label
-    int id = labels.size();
-    Label label;
-    label.target_segment = seg;
-    label.offset = offset;
-    label.name = "L" + std::to_string(id);
-    label_per_seg_by_offset.at(seg)[offset] = id;
-    labels.push_back(label);
-    return id;
-  } else {
+  auto existing = get_label_at(seg, offset);
+  if (existing != -1) {
     // return an existing label
-    auto& label = labels.at(kv->second);
+    auto& label = labels.at(existing);
     assert(label.offset == offset);
     assert(label.target_segment == seg);
-    return kv->second;
+    return existing;
   }
+
+  // create a new label
+  int id = labels.size();
+  Label label;
+  label.target_segment = seg;
+  label.offset = offset;
+  label.name = "L" + std::to_string(id);
+  labels.push_back(label);
+
+  if (labels_finished) {
+    auto& seg_labels = labels_by_seg.at(seg);
+    seg_labels.insert(seg_labels.begin() + first_label_at_or_after(seg, offset), {offset, id});
+  } else {
+    label_per_seg_by_offset.at(seg)[offset] = id;
+  }
+  return id;
 }
 
 /*!
@@ -60,6 +79,15 @@ int LinkedObjectFile::get_label_id_for(int seg, int offset) {
  * Returns -1 if there is no label.
  */
 int LinkedObjectFile::get_label_at(int seg, int offset) const {
+  if (labels_finished) {
+    auto& seg_labels = labels_by_seg.at(seg);
+    auto idx = first_label_at_or_after(seg, offset);
+    if (idx < seg_labels.size() && seg_labels[idx].offset == offset) {
+      return seg_labels[idx].label_id;
+    }
+    return -1;
+  }
+
   auto kv = label_per_seg_by_offset.at(seg).find(offset);
   if (kv == label_per_seg_by_offset.at(seg).end()) {
     return -1;
@@ -68,6 +96,62 @@ int LinkedObjectFile::get_label_at(int seg, int offset) const {
   return kv->second;
 }
 
+/*!
+ * Call once all the labels have been found (after disassembly and fp relative links) to switch to
+ * a sorted array of labels per segment, which the printers can walk through in order.
+ * Labels can still be added after this, but it's slower.
+ */
+void LinkedObjectFile::finish_labels() {
+  assert(!labels_finished);
+  labels_by_seg.resize(segments);
+  for (int seg = 0; seg < segments; seg++) {
+    auto& seg_labels = labels_by_seg.at(seg);
+    for (auto& kv : label_per_seg_by_offset.at(seg)) {
+      seg_labels.push_back({kv.first, kv.second});
+    }
+    std::sort(seg_labels.begin(), seg_labels.end(),
+              [](const LabelAtOffset& a, const LabelAtOffset& b) { return a.offset < b.offset; });
+  }
+  label_per_seg_by_offset.clear();
+  label_per_seg_by_offset.shrink_to_fit();
+  labels_finished = true;
+}
+
+/*!
+ * Get the index in labels_by_seg of the first label at or after the given offset.
+ */
+size_t LinkedObjectFile::first_label_at_or_after(int seg, int offset) const {
+  assert(labels_finished);
+  auto& seg_labels = labels_by_seg.at(seg);
+  auto it = std::lower_bound(
+      seg_labels.begin(), seg_labels.end(), offset,
+      [](const LabelAtOffset& label, int off) { return label.offset < off; });
+  return it - seg_labels.begin();
+}
+
+/*!
+ * Print the labels pointing into the given word. label_cursor should be the index in labels_by_seg
+ * of the first label at or after this word, and will be advanced past the labels in this word.
+ */
+void LinkedObjectFile::print_labels_in_word(BufferedFileWriter& out,
+                                            int seg,
+                                            int word_idx,
+                                            size_t* label_cursor) const {
+  auto& seg_labels = labels_by_seg.at(seg);
+  for (; *label_cursor < seg_labels.size() && seg_labels[*label_cursor].offset < word_idx * 4 + 4;
+       (*label_cursor)++) {
+    auto& label = seg_labels[*label_cursor];
+    int byte = label.offset - word_idx * 4;
+    assert(byte >= 0);
+    out.write(labels.at(label.label_id).name);
+    out.write(':');
+    if (byte != 0) {
+      out.printf(" (offset %d)", byte);
+    }
+    out.write('\n');
+  }
+}
+
 /*!
  * Does this label point to code? Can point to the middle of a function, or the start of a function.
  */
@@ -96,10 +180,39 @@ Function& LinkedObjectFile::get_function_at_label(int label_id) {
 /*!
  * Get the name of the label.
  */
-std::string LinkedObjectFile::get_label_name(int label_id) const {
+const std::string& LinkedObjectFile::get_label_name(int label_id) const {
   return labels.at(label_id).name;
 }
 
+/*!
+ * Get the id for a symbol name, adding it if this is the first time it is used in this file.
+ */
+int LinkedObjectFile::intern_symbol(const std::string& name) {
+  auto kv = symbol_ids_by_name.find(name);
+  if (kv != symbol_ids_by_name.end()) {
+    return kv->second;
+  }
+  int id = int(symbol_names.size());
+  symbol_names.push_back(name);
+  symbol_ids_by_name[name] = id;
+  return id;
+}
+
+/*!
+ * Get the id for a symbol name, or -1 if no word in this file links to this symbol.
+ */
+int LinkedObjectFile::get_symbol_id(const std::string& name) const {
+  auto kv = symbol_ids_by_name.find(name);
+  if (kv == symbol_ids_by_name.end()) {
+    return -1;
+  }
+  return kv->second;
+}
+
+const std::string& LinkedObjectFile::get_symbol_name(int symbol_id) const {
+  return symbol_names.at(symbol_id);
+}
+
 /*!
  * Add link information that a word is a pointer to another word.
  */
@@ -109,8 +222,8 @@ bool LinkedObjectFile::pointer_link_word(int source_segment,
                                          int dest_offset) {
   assert((source_offset % 4) == 0);
 
-  auto& word = words_by_seg.at(source_segment).at(source_offset / 4);
-  assert(word.kind == LinkedWord::PLAIN_DATA);
+  auto& words = words_by_seg.at(source_segment);
+  assert(!words.is_linked(source_offset / 4));
 
   if (dest_offset / 4 > (int)words_by_seg.at(dest_segment).size()) {
     //    printf("HACK bad link ignored!\n");
@@ -118,8 +231,8 @@ bool LinkedObjectFile::pointer_link_word(int source_segment,
   }
   assert(dest_offset / 4 <= (int)words_by_seg.at(dest_segment).size());
 
-  word.kind = LinkedWord::PTR;
-  word.label_id = get_label_id_for(dest_segment, dest_offset);
+  words.set_link_to_label(source_offset / 4, LinkedWord::PTR,
+                          get_label_id_for(dest_segment, dest_offset));
   return true;
 }
 
@@ -131,13 +244,12 @@ void LinkedObjectFile::symbol_link_word(int source_segment,
                                         const char* name,
                                         LinkedWord::Kind kind) {
   assert((source_offset % 4) == 0);
-  auto& word = words_by_seg.at(source_segment).at(source_offset / 4);
-  //  assert(word.kind == LinkedWord::PLAIN_DATA);
-  if (word.kind != LinkedWord::PLAIN_DATA) {
+  auto& words = words_by_seg.at(source_segment);
+  //  assert(word.kind() == LinkedWord::PLAIN_DATA);
+  if (words.is_linked(source_offset / 4)) {
     printf("bad symbol link word\n");
   }
-  word.kind = kind;
-  word.symbol_name = name;
+  words.set_link_to_symbol(source_offset / 4, kind, intern_symbol(name));
 }
 
 /*!
@@ -146,10 +258,9 @@ void LinkedObjectFile::symbol_link_word(int source_segment,
  */
 void LinkedObjectFile::symbol_link_offset(int source_segment, int source_offset, const char* name) {
   assert((source_offset % 4) == 0);
-  auto& word = words_by_seg.at(source_segment).at(source_offset / 4);
-  assert(word.kind == LinkedWord::PLAIN_DATA);
-  word.kind = LinkedWord::SYM_OFFSET;
-  word.symbol_name = name;
+  auto& words = words_by_seg.at(source_segment);
+  assert(!words.is_linked(source_offset / 4));
+  words.set_link_to_symbol(source_offset / 4, LinkedWord::SYM_OFFSET, intern_symbol(name));
 }
 
 /*!
@@ -163,18 +274,15 @@ void LinkedObjectFile::pointer_link_split_word(int source_segment,
   assert((source_hi_offset % 4) == 0);
   assert((source_lo_offset % 4) == 0);
 
-  auto& hi_word = words_by_seg.at(source_segment).at(source_hi_offset / 4);
-  auto& lo_word = words_by_seg.at(source_segment).at(source_lo_offset / 4);
+  auto& words = words_by_seg.at(source_segment);
 
   //  assert(dest_offset / 4 <= (int)words_by_seg.at(dest_segment).size());
-  assert(hi_word.kind == LinkedWord::PLAIN_DATA);
-  assert(lo_word.kind == LinkedWord::PLAIN_DATA);
+  assert(!words.is_linked(source_hi_offset / 4));
+  assert(!words.is_linked(source_lo_offset / 4));
 
-  hi_word.kind = LinkedWord::HI_PTR;
-  hi_word.label_id = get_label_id_for(dest_segment, dest_offset);
-
-  lo_word.kind = LinkedWord::LO_PTR;
-  lo_word.label_id = hi_word.label_id;
+  int label_id = get_label_id_for(dest_segment, dest_offset);
+  words.set_link_to_label(source_hi_offset / 4, LinkedWord::HI_PTR, label_id);
+  words.set_link_to_label(source_lo_offset / 4, LinkedWord::LO_PTR, label_id);
 }
 
 /*!
@@ -207,75 +315,167 @@ static const char* segment_names[] = {"main segment", "debug segment", "top-leve
 /*!
  * Print all the words, with link information and labels.
  */
-std::string LinkedObjectFile::print_words() {
-  std::string result;
-
+void LinkedObjectFile::print_words(BufferedFileWriter& out) {
   assert(segments <= 3);
   for (int seg = segments; seg-- > 0;) {
     // segment header
-    result += ";------------------------------------------\n;  ";
-    result += segment_names[seg];
-    result += "\n;------------------------------------------\n";
+    out.write(";------------------------------------------\n;  ");
+    out.write(segment_names[seg]);
+    out.write("\n;------------------------------------------\n");
 
     // print each word in the segment
-    for (size_t i = 0; i < words_by_seg.at(seg).size(); i++) {
-      for (int j = 0; j < 4; j++) {
-        auto label_id = get_label_at(seg, i * 4 + j);
-        if (label_id != -1) {
-          result += labels.at(label_id).name + ":";
-          if (j != 0) {
-            result += " (offset " + std::to_string(j) + ")";
-          }
-          result += "\n";
-        }
-      }
-
-      auto& word = words_by_seg[seg][i];
-      append_word_to_string(result, word);
+    auto& words = words_by_seg.at(seg);
+    size_t label_cursor = first_label_at_or_after(seg, 0);
+    size_t link_cursor = 0;
+    for (size_t i = 0; i < words.size(); i++) {
+      print_labels_in_word(out, seg, i, &label_cursor);
+      print_word(out, words.at(i, link_cursor));
     }
   }
-
-  return result;
 }
 
 /*!
- * Add a word's printed representation to the end of a string. Internal helper for print_words.
+ * Print a word's representation to buff. Returns the length.
  */
-void LinkedObjectFile::append_word_to_string(std::string& dest, const LinkedWord& word) const {
-  char buff[128];
-
-  switch (word.kind) {
+int LinkedObjectFile::format_word(char* buff, size_t size, const LinkedWord& word) const {
+  int len = 0;
+  switch (word.kind()) {
     case LinkedWord::PLAIN_DATA:
-      sprintf(buff, "    .word 0x%x\n", word.data);
+      len = snprintf(buff, size, "    .word 0x%x\n", word.data);
       break;
     case LinkedWord::PTR:
-      sprintf(buff, "    .word %s\n", labels.at(word.label_id).name.c_str());
+      len = snprintf(buff, size, "    .word %s\n", labels.at(word.label_id()).name.c_str());
       break;
     case LinkedWord::SYM_PTR:
-      sprintf(buff, "    .symbol %s\n", word.symbol_name.c_str());
+      len = snprintf(buff, size, "    .symbol %s\n", get_symbol_name(word.symbol_id()).c_str());
       break;
     case LinkedWord::TYPE_PTR:
-      sprintf(buff, "    .type %s\n", word.symbol_name.c_str());
+      len = snprintf(buff, size, "    .type %s\n", get_symbol_name(word.symbol_id()).c_str());
       break;
     case LinkedWord::EMPTY_PTR:
-      sprintf(buff, "    .empty-list\n");  // ?
+      len = snprintf(buff, size, "    .empty-list\n");  // ?
       break;
     case LinkedWord::HI_PTR:
-      sprintf(buff, "    .ptr-hi 0x%x %s\n", word.data >> 16,
-              labels.at(word.label_id).name.c_str());
+      len = snprintf(buff, size, "    .ptr-hi 0x%x %s\n", word.data >> 16,
+                     labels.at(word.label_id()).name.c_str());
       break;
     case LinkedWord::LO_PTR:
-      sprintf(buff, "    .ptr-lo 0x%x %s\n", word.data >> 16,
-              labels.at(word.label_id).name.c_str());
+      len = snprintf(buff, size, "    .ptr-lo 0x%x %s\n", word.data >> 16,
+                     labels.at(word.label_id()).name.c_str());
       break;
     case LinkedWord::SYM_OFFSET:
-      sprintf(buff, "    .sym-off 0x%x %s\n", word.data >> 16, word.symbol_name.c_str());
+      len = snprintf(buff, size, "    .sym-off 0x%x %s\n", word.data >> 16,
+                     get_symbol_name(word.symbol_id()).c_str());
       break;
     default:
       throw std::runtime_error("nyi");
   }
 
-  dest += buff;
+  assert(len >= 0 && size_t(len) < size);
+  return len;
+}
+
+/*!
+ * Add a word's printed representation to the end of a string.
+ */
+void LinkedObjectFile::append_word_to_string(std::string& dest, const LinkedWord& word) const {
+  char buff[256];
+  dest.append(buff, format_word(buff, sizeof(buff), word));
+}
+
+/*!
+ * Write a word's printed representation. Internal helper for the printers.
+ */
+void LinkedObjectFile::print_word(BufferedFileWriter& out, const LinkedWord& word) const {
+  char buff[256];
+  out.write(buff, format_word(buff, sizeof(buff), word));
+}
+
+static_assert(std::is_trivially_copyable<LinkedObjectFile::Stats>::value,
+              "stats are written to the cache as raw bytes");
+
+/*!
+ * Write everything found by linking, find_code, find_functions and process_fp_relative_links to a
+ * cache entry. All functions must be disassembled, and labels must not be finished yet.
+ */
+void LinkedObjectFile::write_to(BinaryWriter& out) const {
+  assert(!labels_finished);
+  out.add(stats);
+  out.add<uint32_t>(segments);
+  for (int seg = 0; seg < segments; seg++) {
+    words_by_seg.at(seg).write_to(out);
+    out.add<uint32_t>(offset_of_data_zone_by_seg.at(seg));
+    out.add<uint32_t>(functions_by_seg.at(seg).size());
+    for (auto& function : functions_by_seg.at(seg)) {
+      assert(function.disassembled &&
+             int(function.instructions.size()) == function.end_word - function.start_word);
+      out.add<int32_t>(function.start_word);
+      out.add<int32_t>(function.end_word);
+      out.add<uint8_t>(function.uses_fp_register);
+      out.add<uint8_t>(function.fp_links_done);
+      for (auto& instr : function.instructions) {
+        instr.write_to(out);
+      }
+    }
+  }
+
+  out.add<uint32_t>(labels.size());
+  for (auto& label : labels) {
+    out.add<int32_t>(label.target_segment);
+    out.add<int32_t>(label.offset);
+    out.add_string(label.name);
+  }
+
+  out.add<uint32_t>(symbol_names.size());
+  for (auto& name : symbol_names) {
+    out.add_string(name);
+  }
+}
+
+/*!
+ * Read a cache entry written by write_to into an empty LinkedObjectFile.
+ */
+void LinkedObjectFile::read_from(BinaryReader& in) {
+  assert(segments == 0);
+  stats = in.read<Stats>();
+  int n_segs = in.read<uint32_t>();
+  if (n_segs) {
+    set_segment_count(n_segs);
+  }
+  for (int seg = 0; seg < segments; seg++) {
+    words_by_seg.at(seg).read_from(in);
+    offset_of_data_zone_by_seg.at(seg) = in.read<uint32_t>();
+    auto n_functions = in.read<uint32_t>();
+    for (uint32_t i = 0; i < n_functions; i++) {
+      int start_word = in.read<int32_t>();
+      int end_word = in.read<int32_t>();
+      functions_by_seg.at(seg).emplace_back(start_word, end_word);
+      auto& function = functions_by_seg.at(seg).back();
+      function.uses_fp_register = in.read<uint8_t>();
+      function.fp_links_done = in.read<uint8_t>();
+      function.instructions.resize(end_word - start_word);
+      for (auto& instr : function.instructions) {
+        instr.read_from(in);
+      }
+      function.disassembled = true;
+    }
+  }
+
+  labels.resize(in.read<uint32_t>());
+  for (size_t i = 0; i < labels.size(); i++) {
+    auto& label = labels[i];
+    label.target_segment = in.read<int32_t>();
+    label.offset = in.read<int32_t>();
+    label.name = in.read_string();
+    label_per_seg_by_offset.at(label.target_segment)[label.offset] = i;
+  }
+
+  auto n_symbols = in.read<uint32_t>();
+  symbol_names.reserve(n_symbols);
+  for (uint32_t i = 0; i < n_symbols; i++) {
+    symbol_names.push_back(in.read_string());
+    symbol_ids_by_name[symbol_names.back()] = i;
+  }
 }
 
 /*!
@@ -284,10 +484,10 @@ void LinkedObjectFile::append_word_to_string(std::string& dest, const LinkedWord
 void LinkedObjectFile::find_code() {
   if (segments == 1) {
     // single segment object files should never have any code.
-    auto& seg = words_by_seg.front();
-    for (auto& word : seg) {
-      if (!word.symbol_name.empty()) {
-        assert(word.symbol_name != "function");
+    int function_symbol = get_symbol_id("function");
+    for (auto& link : words_by_seg.front().links()) {
+      if (link.word.has_symbol()) {
+        assert(link.word.symbol_id() != function_symbol);
       }
     }
     offset_of_data_zone_by_seg.at(0) = 0;
@@ -297,33 +497,36 @@ void LinkedObjectFile::find_code() {
   } else if (segments == 3) {
     // V3 object files will have all the functions, then all the static data.  So to find the
     // divider, we look for the last "function" tag, then find the last jr $ra instruction after
-    // that (plus one for delay slot) and assume that after that is data.  Additionally, we check to
-    // make sure that there are no "function" type tags in the data section, although this is
-    // redundant.
+    // that (plus one for delay slot) and assume that after that is data.
+    int function_symbol = get_symbol_id("function");
     for (int i = 0; i < segments; i++) {
+      auto& words = words_by_seg.at(i);
+      auto& type_tags = words.type_tags();
+
       // try to find the last reference to "function":
       bool found_function = false;
       size_t function_loc = -1;
-      for (size_t j = words_by_seg.at(i).size(); j-- > 0;) {
-        auto& word = words_by_seg.at(i).at(j);
-        if (word.kind == LinkedWord::TYPE_PTR && word.symbol_name == "function") {
-          function_loc = j;
+      for (size_t j = type_tags.size(); j-- > 0;) {
+        if (type_tags[j].word.symbol_id() == function_symbol) {
+          function_loc = type_tags[j].word_idx;
           found_function = true;
           break;
         }
       }
 
       if (found_function) {
-        // look forward until we find "jr ra"
+        // look backward from the end until we find "jr ra". The last one is the end of the code,
+        // so this only has to scan the data.
         const uint32_t jr_ra = 0x3e00008;
         bool found_jr_ra = false;
         size_t jr_ra_loc = -1;
 
-        for (size_t j = function_loc; j < words_by_seg.at(i).size(); j++) {
-          auto& word = words_by_seg.at(i).at(j);
-          if (word.kind == LinkedWord::PLAIN_DATA && word.data == jr_ra) {
+        auto& data = words.all_data();
+        for (size_t j = data.size(); j-- > function_loc;) {
+          if (data[j] == jr_ra && words.at(j).kind() == LinkedWord::PLAIN_DATA) {
             found_jr_ra = true;
             jr_ra_loc = j;
+            break;
           }
         }
 
@@ -342,13 +545,9 @@ void LinkedObjectFile::find_code() {
         labels.at(data_label_id).name = "L-data-start";
       }
 
-      // verify there are no functions after the data section starts
-      for (size_t j = offset_of_data_zone_by_seg.at(i); j < words_by_seg.at(i).size(); j++) {
-        auto& word = words_by_seg.at(i).at(j);
-        if (word.kind == LinkedWord::TYPE_PTR && word.symbol_name == "function") {
-          assert(false);
-        }
-      }
+      // there are no functions after the data section starts, because the last function tag is
+      // before the last jr ra.
+      assert(!found_function || function_loc < offset_of_data_zone_by_seg.at(i));
 
       // sizes:
       stats.data_bytes += 4 * (words_by_seg.at(i).size() - offset_of_data_zone_by_seg.at(i)) * 4;
@@ -372,16 +571,23 @@ void LinkedObjectFile::find_functions() {
     // mark the end of the previous function and the start of the next.  This means that some
     // functions will have a few 0x0 words after then for padding (GOAL functions are aligned), but
     // this is something that the disassembler should handle.
+    int function_symbol = get_symbol_id("function");
     for (int seg = 0; seg < segments; seg++) {
+      auto& type_tags = words_by_seg.at(seg).type_tags();
       // start at the end and work backward...
       int function_end = offset_of_data_zone_by_seg.at(seg);
+      // there are no function tags in the data, so all type tags after this are ignored.
+      size_t tag_idx = type_tags.size();
+      while (tag_idx > 0 && int(type_tags[tag_idx - 1].word_idx) >= function_end) {
+        tag_idx--;
+      }
       while (function_end > 0) {
         // back up until we find function type tag
         int function_tag_loc = function_end;
         bool found_function_tag_loc = false;
-        for (; function_tag_loc-- > 0;) {
-          auto& word = words_by_seg.at(seg).at(function_tag_loc);
-          if (word.kind == LinkedWord::TYPE_PTR && word.symbol_name == "function") {
+        while (tag_idx-- > 0) {
+          if (type_tags[tag_idx].word.symbol_id() == function_symbol) {
+            function_tag_loc = type_tags[tag_idx].word_idx;
             found_function_tag_loc = true;
             break;
           }
@@ -399,19 +605,58 @@ void LinkedObjectFile::find_functions() {
   }
 }
 
+/*!
+ * Run the disassembler on a function, if it hasn't been done already.
+ * Anything that looks at a function's instructions should call this first. Decoding adds labels
+ * for branch targets, so if the labels will be printed, this must happen before process_labels.
+ * If the instructions were freed by release_instructions, they are decoded again, and the
+ * fp-relative links are resolved again if they were before.
+ */
+void LinkedObjectFile::disassemble_function(int seg, Function& function) {
+  if (function.disassembled) {
+    return;
+  }
+
+  auto& words = words_by_seg.at(seg);
+  size_t link_cursor = words.first_link_at_or_after(function.start_word);
+  function.instructions.reserve(function.end_word - function.start_word);
+  for (auto word = function.start_word; word < function.end_word; word++) {
+    // decode!
+    function.instructions.push_back(
+        decode_instruction(words.at(word, link_cursor), *this, seg, word));
+    if (function.instructions.back().is_valid() && !function.instructions_released) {
+      stats.decoded_ops++;
+    }
+  }
+  function.disassembled = true;
+
+  if (function.fp_links_done) {
+    process_fp_relative_links(seg, function);
+  }
+}
+
 /*!
  * Run the disassembler on all functions.
  */
 void LinkedObjectFile::disassemble_functions() {
   for (int seg = 0; seg < segments; seg++) {
     for (auto& function : functions_by_seg.at(seg)) {
-      for (auto word = function.start_word; word < function.end_word; word++) {
-        // decode!
-        function.instructions.push_back(
-            decode_instruction(words_by_seg.at(seg).at(word), *this, seg, word));
-        if (function.instructions.back().is_valid()) {
-          stats.decoded_ops++;
-        }
+      disassemble_function(seg, function);
+    }
+  }
+}
+
+/*!
+ * Free the instructions of all functions, once nothing needs them anymore.
+ */
+void LinkedObjectFile::release_instructions() {
+  for (auto& seg_functions : functions_by_seg) {
+    for (auto& function : seg_functions) {
+      if (function.disassembled) {
+        function.instructions.clear();
+        function.instructions.shrink_to_fit();
+        function.disassembled = false;
+        function.instructions_released = true;
       }
     }
   }
@@ -423,139 +668,171 @@ void LinkedObjectFile::disassemble_functions() {
 void LinkedObjectFile::process_fp_relative_links() {
   for (int seg = 0; seg < segments; seg++) {
     for (auto& function : functions_by_seg.at(seg)) {
-      for (size_t instr_idx = 0; instr_idx < function.instructions.size(); instr_idx++) {
-        // we possibly need to look at three instructions
-        auto& instr = function.instructions[instr_idx];
-        auto* prev_instr = (instr_idx > 0) ? &function.instructions[instr_idx - 1] : nullptr;
-        auto* pprev_instr = (instr_idx > 1) ? &function.instructions[instr_idx - 2] : nullptr;
-
-        // ignore storing FP onto the stack
-        if ((instr.kind == InstructionKind::SD || instr.kind == InstructionKind::SQ) &&
-            instr.get_src(0).get_reg() == Register(Reg::GPR, Reg::FP)) {
-          continue;
-        }
+      disassemble_function(seg, function);
+      if (!function.fp_links_done) {
+        process_fp_relative_links(seg, function);
+      }
+    }
+  }
+}
+
+/*!
+ * Resolve the fp-relative data access in one disassembled function. Only the first time counts
+ * toward the stats, in case the instructions were released and decoded again.
+ */
+void LinkedObjectFile::process_fp_relative_links(int seg, Function& function) {
+  assert(function.disassembled);
+  bool add_stats = !function.fp_links_done;
+  for (size_t instr_idx = 0; instr_idx < function.instructions.size(); instr_idx++) {
+    // we possibly need to look at three instructions
+    auto& instr = function.instructions[instr_idx];
+    auto* prev_instr = (instr_idx > 0) ? &function.instructions[instr_idx - 1] : nullptr;
+    auto* pprev_instr = (instr_idx > 1) ? &function.instructions[instr_idx - 2] : nullptr;
+
+    // ignore storing FP onto the stack
+    if ((instr.kind == InstructionKind::SD || instr.kind == InstructionKind::SQ) &&
+        instr.get_src(0).get_reg() == Register(Reg::GPR, Reg::FP)) {
+      continue;
+    }
+
+    // HACKs
+    if (instr.kind == InstructionKind::PEXTLW) {
+      continue;
+    }
 
-        // HACKs
-        if (instr.kind == InstructionKind::PEXTLW) {
-          continue;
+    // search over instruction sources
+    for (int i = 0; i < instr.n_src; i++) {
+      auto& src = instr.src[i];
+      if (src.kind == InstructionAtom::REGISTER     // must be reg
+          && src.get_reg().get_kind() == Reg::GPR   // gpr
+          && src.get_reg().get_gpr() == Reg::FP) {  // fp reg.
+
+        if (add_stats) {
+          stats.n_fp_reg_use++;
         }
 
-        // search over instruction sources
-        for (int i = 0; i < instr.n_src; i++) {
-          auto& src = instr.src[i];
-          if (src.kind == InstructionAtom::REGISTER     // must be reg
-              && src.get_reg().get_kind() == Reg::GPR   // gpr
-              && src.get_reg().get_gpr() == Reg::FP) {  // fp reg.
-
-            stats.n_fp_reg_use++;
-
-            // offset of fp at this instruction.
-            int current_fp = 4 * (function.start_word + 1);
-            function.uses_fp_register = true;
-
-            switch (instr.kind) {
-              // fp-relative load
-              case InstructionKind::LW:
-              case InstructionKind::LWC1:
-              case InstructionKind::LD:
-              // generate pointer to fp-relative data
-              case InstructionKind::DADDIU: {
-                auto& atom = instr.get_imm_src();
-                atom.set_label(get_label_id_for(seg, current_fp + atom.get_imm()));
-                stats.n_fp_reg_use_resolved++;
-              } break;
-
-              // in the case that addiu doesn't have enough range (+/- 2^15), GOAL has two
-              // strategies: 1). use ori + daddu (ori doesn't sign extend, so this lets us go +2^16,
-              // -0) 2). use lui + ori + daddu (can reach anywhere in the address space) It seems
-              // that addu is used to get pointers to floating point values and daddu is used in
-              // other cases. Also, the position of the fp register is swapped between the two.
-              case InstructionKind::DADDU:
-              case InstructionKind::ADDU: {
-                assert(prev_instr);
-                assert(prev_instr->kind == InstructionKind::ORI);
-                int offset_reg_src_id = instr.kind == InstructionKind::DADDU ? 0 : 1;
-                auto offset_reg = instr.get_src(offset_reg_src_id).get_reg();
-                assert(offset_reg == prev_instr->get_dst(0).get_reg());
-                assert(offset_reg == prev_instr->get_src(0).get_reg());
-                auto& atom = prev_instr->get_imm_src();
-                int additional_offset = 0;
-                if (pprev_instr && pprev_instr->kind == InstructionKind::LUI) {
-                  assert(pprev_instr->get_dst(0).get_reg() == offset_reg);
-                  additional_offset = (1 << 16) * pprev_instr->get_imm_src().get_imm();
-                }
-                atom.set_label(
-                    get_label_id_for(seg, current_fp + atom.get_imm() + additional_offset));
-                stats.n_fp_reg_use_resolved++;
-              } break;
-
-              default:
-                printf("unknown fp using op: %s\n", instr.to_string(*this).c_str());
-                assert(false);
+        // offset of fp at this instruction.
+        int current_fp = 4 * (function.start_word + 1);
+        function.uses_fp_register = true;
+
+        switch (instr.kind) {
+          // fp-relative load
+          case InstructionKind::LW:
+          case InstructionKind::LWC1:
+          case InstructionKind::LD:
+          // generate pointer to fp-relative data
+          case InstructionKind::DADDIU: {
+            auto& atom = instr.get_imm_src();
+            atom.set_label(get_label_id_for(seg, current_fp + atom.get_imm()));
+            if (add_stats) {
+              stats.n_fp_reg_use_resolved++;
             }
-          }
+          } break;
+
+          // in the case that addiu doesn't have enough range (+/- 2^15), GOAL has two
+          // strategies: 1). use ori + daddu (ori doesn't sign extend, so this lets us go +2^16,
+          // -0) 2). use lui + ori + daddu (can reach anywhere in the address space) It seems
+          // that addu is used to get pointers to floating point values and daddu is used in
+          // other cases. Also, the position of the fp register is swapped between the two.
+          case InstructionKind::DADDU:
+          case InstructionKind::ADDU: {
+            assert(prev_instr);
+            assert(prev_instr->kind == InstructionKind::ORI);
+            int offset_reg_src_id = instr.kind == InstructionKind::DADDU ? 0 : 1;
+            auto offset_reg = instr.get_src(offset_reg_src_id).get_reg();
+            assert(offset_reg == prev_instr->get_dst(0).get_reg());
+            assert(offset_reg == prev_instr->get_src(0).get_reg());
+            auto& atom = prev_instr->get_imm_src();
+            int additional_offset = 0;
+            if (pprev_instr && pprev_instr->kind == InstructionKind::LUI) {
+              assert(pprev_instr->get_dst(0).get_reg() == offset_reg);
+              additional_offset = (1 << 16) * pprev_instr->get_imm_src().get_imm();
+            }
+            atom.set_label(
+                get_label_id_for(seg, current_fp + atom.get_imm() + additional_offset));
+            if (add_stats) {
+              stats.n_fp_reg_use_resolved++;
+            }
+          } break;
+
+          default:
+            printf("unknown fp using op: %s\n", instr.to_string(*this).c_str());
+            assert(false);
         }
       }
     }
   }
+  function.fp_links_done = true;
 }
 
 /*!
  * Print disassembled functions and data segments.
  */
-std::string LinkedObjectFile::print_disassembly() {
+void LinkedObjectFile::print_disassembly(BufferedFileWriter& out) {
   bool write_hex = get_config().write_hex_near_instructions;
-  std::string result;
+  int string_symbol = get_symbol_id("string");
 
   assert(segments <= 3);
   for (int seg = segments; seg-- > 0;) {
     // segment header
-    result += ";------------------------------------------\n;  ";
-    result += segment_names[seg];
-    result += "\n;------------------------------------------\n\n";
+    out.write(";------------------------------------------\n;  ");
+    out.write(segment_names[seg]);
+    out.write("\n;------------------------------------------\n\n");
 
     // functions
     for (auto& func : functions_by_seg.at(seg)) {
-      result += ";;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;\n";
-      result += "; .function " + func.guessed_name + "\n";
-      result += ";;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;\n";
-      result += func.prologue.to_string(2) + "\n";
+      disassemble_function(seg, func);
+      out.write(";;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;\n");
+      out.write("; .function ");
+      out.write(func.guessed_name);
+      out.write('\n');
+      out.write(";;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;\n");
+      out.write(func.prologue.to_string(2));
+      out.write('\n');
 
       // print each instruction in the function.
       bool in_delay_slot = false;
+      std::string instr_str;
+      instr_str.reserve(128);
 
+      auto& seg_labels = labels_by_seg.at(seg);
+      size_t label_cursor = first_label_at_or_after(seg, (func.start_word + 1) * 4);
+      size_t link_cursor = words_by_seg[seg].first_link_at_or_after(func.start_word + 1);
       for (int i = 1; i < func.end_word - func.start_word; i++) {
-        auto label_id = get_label_at(seg, (func.start_word + i) * 4);
-        if (label_id != -1) {
-          result += labels.at(label_id).name + ":\n";
-        }
-
-        for (int j = 1; j < 4; j++) {
-          //          assert(get_label_at(seg, (func.start_word + i)*4 + j) == -1);
-          if (get_label_at(seg, (func.start_word + i) * 4 + j) != -1) {
-            result += "BAD OFFSET LABEL: ";
-            result += labels.at(get_label_at(seg, (func.start_word + i) * 4 + j)).name + "\n";
+        int word_offset = (func.start_word + i) * 4;
+        for (; label_cursor < seg_labels.size() && seg_labels[label_cursor].offset < word_offset + 4;
+             label_cursor++) {
+          auto& label = seg_labels[label_cursor];
+          if (label.offset == word_offset) {
+            out.write(labels.at(label.label_id).name);
+            out.write(":\n");
+          } else {
+            out.write("BAD OFFSET LABEL: ");
+            out.write(labels.at(label.label_id).name);
+            out.write('\n');
             assert(false);
           }
         }
 
         auto& instr = func.instructions.at(i);
-        std::string line = "    " + instr.to_string(*this);
+        instr_str.clear();
+        instr.append_to(instr_str, *this);
+        out.write("    ");
+        out.write(instr_str);
 
         if (write_hex) {
-          if (line.length() < 60) {
-            line.append(60 - line.length(), ' ');
+          size_t line_length = 4 + instr_str.length();
+          if (line_length < 60) {
+            out.write_spaces(60 - line_length);
           }
-          result += line;
-          result += " ;;";
-          auto& word = words_by_seg[seg].at(func.start_word + i);
-          append_word_to_string(result, word);
+          out.write(" ;;");
+          print_word(out, words_by_seg[seg].at(func.start_word + i, link_cursor));
         } else {
-          result += line + "\n";
+          out.write('\n');
         }
 
         if (in_delay_slot) {
-          result += "\n";
+          out.write('\n');
           in_delay_slot = false;
         }
 
@@ -563,44 +840,26 @@ std::string LinkedObjectFile::print_disassembly() {
           in_delay_slot = true;
         }
       }
-      result += "\n";
-      //
-      //      int bid = 0;
-      //      for(auto& bblock : func.basic_blocks) {
-      //        result += "BLOCK " + std::to_string(bid++)+ "\n";
-      //        for(int i = bblock.start_word; i < bblock.end_word; i++) {
-      //          if(i >= 0 && i < func.instructions.size()) {
-      //            result += func.instructions.at(i).to_string(*this) + "\n";
-      //          } else {
-      //            result += "BAD BBLOCK INSTR ID " + std::to_string(i);
-      //          }
-      //        }
-      //      }
+      out.write('\n');
     }
 
     // print data
-    for (size_t i = offset_of_data_zone_by_seg.at(seg); i < words_by_seg.at(seg).size(); i++) {
-      for (int j = 0; j < 4; j++) {
-        auto label_id = get_label_at(seg, i * 4 + j);
-        if (label_id != -1) {
-          result += labels.at(label_id).name + ":";
-          if (j != 0) {
-            result += " (offset " + std::to_string(j) + ")";
-          }
-          result += "\n";
-        }
-      }
-
-      auto& word = words_by_seg[seg][i];
-      append_word_to_string(result, word);
-
-      if (word.kind == LinkedWord::TYPE_PTR && word.symbol_name == "string") {
-        result += "; " + get_goal_string(seg, i) + "\n";
+    auto& words = words_by_seg.at(seg);
+    size_t label_cursor = first_label_at_or_after(seg, offset_of_data_zone_by_seg.at(seg) * 4);
+    size_t link_cursor = words.first_link_at_or_after(offset_of_data_zone_by_seg.at(seg));
+    for (size_t i = offset_of_data_zone_by_seg.at(seg); i < words.size(); i++) {
+      print_labels_in_word(out, seg, i, &label_cursor);
+
+      auto word = words.at(i, link_cursor);
+      print_word(out, word);
+
+      if (word.kind() == LinkedWord::TYPE_PTR && word.symbol_id() == string_symbol) {
+        out.write("; ");
+        out.write(get_goal_string(seg, i));
+        out.write('\n');
       }
     }
   }
-
-  return result;
 }
 
 /*!
@@ -612,8 +871,8 @@ std::string LinkedObjectFile::get_goal_string(int seg, int word_idx) {
   if (word_idx + 1 >= int(words_by_seg[seg].size())) {
     return "invalid string!\n";
   }
-  LinkedWord& size_word = words_by_seg[seg].at(word_idx + 1);
-  if (size_word.kind != LinkedWord::PLAIN_DATA) {
+  auto size_word = words_by_seg[seg].at(word_idx + 1);
+  if (size_word.kind() != LinkedWord::PLAIN_DATA) {
     // sometimes an array of string pointer triggers this!
     return "invalid string!\n";
   }
@@ -623,8 +882,8 @@ std::string LinkedObjectFile::get_goal_string(int seg, int word_idx) {
   for (size_t i = 0; i < size_word.data; i++) {
     int word_offset = word_idx + 2 + (i / 4);
     int byte_offset = i % 4;
-    auto& word = words_by_seg[seg].at(word_offset);
-    if (word.kind != LinkedWord::PLAIN_DATA) {
+    auto word = words_by_seg[seg].at(word_offset);
+    if (word.kind() != LinkedWord::PLAIN_DATA) {
       return "invalid string! (check me!)\n";
     }
     char cword[4];
@@ -650,26 +909,42 @@ bool LinkedObjectFile::has_any_functions() {
  */
 std::string LinkedObjectFile::print_scripts() {
   std::string result;
+  // all forms for the scripts in this object, freed all at once at the end.
+  Arena arena;
+  for (auto* script : find_scripts(arena)) {
+    result += script->toStringPretty(0, 100) + "\n";
+  }
+  return result;
+}
+
+/*!
+ * Find all scripts in this file and convert them to forms, in the order they are printed.
+ */
+std::vector<Form*> LinkedObjectFile::find_scripts(Arena& arena) {
+  std::vector<Form*> result;
   for (int seg = 0; seg < segments; seg++) {
     std::vector<bool> already_printed(words_by_seg[seg].size(), false);
 
     // the linked list layout algorithm of GOAL puts the first pair first.
     // so we want to go in forward order to catch the beginning correctly
-    for (size_t word_idx = 0; word_idx < words_by_seg[seg].size(); word_idx++) {
+    for (auto& label : labels_by_seg.at(seg)) {
+      // check for linked list by looking for anything that accesses this as a pair (offset of 2)
+      if (label.offset < 0 || (label.offset & 7) != 2) {
+        continue;
+      }
+
+      size_t word_idx = label.offset / 4;
+      if (word_idx >= words_by_seg[seg].size()) {
+        break;
+      }
+
       // don't print parts of scripts we've already seen
       // (note that scripts could share contents, which is supported, this is just for starting
       // off a script print)
       if (already_printed[word_idx])
         continue;
 
-      // check for linked list by looking for anything that accesses this as a pair (offset of 2)
-      auto label_id = get_label_at(seg, 4 * word_idx + 2);
-      if (label_id != -1) {
-        auto& label = labels.at(label_id);
-        if ((label.offset & 7) == 2) {
-          result += to_form_script(seg, word_idx, already_printed)->toStringPretty(0, 100) + "\n";
-        }
-      }
+      result.push_back(to_form_script(arena, seg, word_idx, already_printed));
     }
   }
   return result;
@@ -680,8 +955,8 @@ std::string LinkedObjectFile::print_scripts() {
  */
 bool LinkedObjectFile::is_empty_list(int seg, int byte_idx) {
   assert((byte_idx % 4) == 0);
-  auto& word = words_by_seg.at(seg).at(byte_idx / 4);
-  return word.kind == LinkedWord::EMPTY_PTR;
+  auto word = words_by_seg.at(seg).at(byte_idx / 4);
+  return word.kind() == LinkedWord::EMPTY_PTR;
 }
 
 /*!
@@ -689,26 +964,26 @@ bool LinkedObjectFile::is_empty_list(int seg, int byte_idx) {
  * Note : this takes the address of the car of the pair. which is perhaps a bit confusing
  * (in GOAL, this would be (&-> obj car))
  */
-std::shared_ptr<Form> LinkedObjectFile::to_form_script(int seg,
-                                                       int word_idx,
-                                                       std::vector<bool>& seen) {
+Form* LinkedObjectFile::to_form_script(Arena& arena,
+                                      int seg,
+                                      int word_idx,
+                                      std::vector<bool>& seen) {
   // the object to currently print. to start off, create pair from the car address we've been given.
   int goal_print_obj = word_idx * 4 + 2;
 
   // resulting form. we can't have a totally empty list (as an empty list looks like a symbol,
   // so it wouldn't be flagged), so it's safe to make this a pair.
-  auto result = std::make_shared<Form>();
-  result->kind = FormKind::PAIR;
+  auto* result = buildPair(arena, nullptr, nullptr);
 
   // the current pair to fill out.
-  auto fill = result;
+  auto* fill = result;
 
   // loop until we run out of things to add
   for (;;) {
     // check the thing to print is a a pair.
     if ((goal_print_obj & 7) == 2) {
       // first convert the car (again, with (&-> obj car))
-      fill->pair[0] = to_form_script_object(seg, goal_print_obj - 2, seen);
+      fill->pair[0] = to_form_script_object(arena, seg, goal_print_obj - 2, seen);
       seen.at(goal_print_obj / 4) = true;
 
       auto cdr_addr = goal_print_obj + 2;
@@ -720,17 +995,17 @@ std::shared_ptr<Form> LinkedObjectFile::to_form_script(int seg,
       } else {
         // cdr object should be aligned.
         assert((cdr_addr % 4) == 0);
-        auto& cdr_word = words_by_seg.at(seg).at(cdr_addr / 4);
+        auto cdr_word = words_by_seg.at(seg).at(cdr_addr / 4);
         // check for proper list
-        if (cdr_word.kind == LinkedWord::PTR && (labels.at(cdr_word.label_id).offset & 7) == 2) {
+        if (cdr_word.kind() == LinkedWord::PTR &&
+            (labels.at(cdr_word.label_id()).offset & 7) == 2) {
           // yes, proper list. add another pair and link it in to the list.
-          goal_print_obj = labels.at(cdr_word.label_id).offset;
-          fill->pair[1] = std::make_shared<Form>();
-          fill->pair[1]->kind = FormKind::PAIR;
+          goal_print_obj = labels.at(cdr_word.label_id()).offset;
+          fill->pair[1] = buildPair(arena, nullptr, nullptr);
           fill = fill->pair[1];
         } else {
           // improper list, put the last thing in and end
-          fill->pair[1] = to_form_script_object(seg, cdr_addr, seen);
+          fill->pair[1] = to_form_script_object(arena, seg, cdr_addr, seen);
           return result;
         }
       }
@@ -755,43 +1030,45 @@ bool LinkedObjectFile::is_string(int seg, int byte_idx) {
   if (type_tag_ptr < 0 || size_t(type_tag_ptr) >= words_by_seg.at(seg).size() * 4) {
     return false;
   }
-  auto& type_word = words_by_seg.at(seg).at(type_tag_ptr / 4);
-  return type_word.kind == LinkedWord::TYPE_PTR && type_word.symbol_name == "string";
+  auto type_word = words_by_seg.at(seg).at(type_tag_ptr / 4);
+  return type_word.kind() == LinkedWord::TYPE_PTR &&
+         type_word.symbol_id() == get_symbol_id("string");
 }
 
 /*!
  * Convert a (pointer object) to some nice representation.
  */
-std::shared_ptr<Form> LinkedObjectFile::to_form_script_object(int seg,
-                                                              int byte_idx,
-                                                              std::vector<bool>& seen) {
-  std::shared_ptr<Form> result;
+Form* LinkedObjectFile::to_form_script_object(Arena& arena,
+                                             int seg,
+                                             int byte_idx,
+                                             std::vector<bool>& seen) {
+  Form* result = nullptr;
 
   switch (byte_idx & 7) {
     case 0:
     case 4: {
-      auto& word = words_by_seg.at(seg).at(byte_idx / 4);
-      if (word.kind == LinkedWord::SYM_PTR) {
+      auto word = words_by_seg.at(seg).at(byte_idx / 4);
+      if (word.kind() == LinkedWord::SYM_PTR) {
         // .symbol xxxx
-        result = toForm(word.symbol_name);
-      } else if (word.kind == LinkedWord::PLAIN_DATA) {
+        result = toForm(arena, get_symbol_name(word.symbol_id()));
+      } else if (word.kind() == LinkedWord::PLAIN_DATA) {
         // .word xxxxx
-        result = toForm(std::to_string(word.data));
-      } else if (word.kind == LinkedWord::PTR) {
+        result = toForm(arena, std::to_string(word.data));
+      } else if (word.kind() == LinkedWord::PTR) {
         // might be a sub-list, or some other random pointer
-        auto offset = labels.at(word.label_id).offset;
+        auto offset = labels.at(word.label_id()).offset;
         if ((offset & 7) == 2) {
           // list!
-          result = to_form_script(seg, offset / 4, seen);
+          result = to_form_script(arena, seg, offset / 4, seen);
         } else {
           if (is_string(seg, offset)) {
-            result = toForm(get_goal_string(seg, offset / 4 - 1));
+            result = toForm(arena, get_goal_string(seg, offset / 4 - 1));
           } else {
             // some random pointer, just print the label.
-            result = toForm(labels.at(word.label_id).name);
+            result = toForm(arena, labels.at(word.label_id()).name);
           }
         }
-      } else if (word.kind == LinkedWord::EMPTY_PTR) {
+      } else if (word.kind() == LinkedWord::EMPTY_PTR) {
         result = gSymbolTable.getEmptyPair();
       } else {
         std::string debug;
@@ -12,9 +12,14 @@
 #include <unordered_map>
 #include <unordered_set>
 #include "LinkedWord.h"
+#include "SegmentWords.h"
 #include "Function/Function.h"
 #include "util/LispPrint.h"
 
+class BinaryReader;
+class BinaryWriter;
+class BufferedFileWriter;
+
 
 /*!
  * A label to a location in this object file.
@@ -33,26 +38,37 @@ class LinkedObjectFile {
 public:
   LinkedObjectFile() = default;
   void set_segment_count(int n_segs);
-  void push_back_word_to_segment(uint32_t word, int segment);
+  void set_segment_words(int segment, const uint8_t* data, size_t word_count);
+  void finish_linking();
   int get_label_id_for(int seg, int offset);
   int get_label_at(int seg, int offset) const;
+  void finish_labels();
   bool label_points_to_code(int label_id) const;
   bool pointer_link_word(int source_segment, int source_offset, int dest_segment, int dest_offset);
   void pointer_link_split_word(int source_segment, int source_hi_offset, int source_lo_offset, int dest_segment, int dest_offset);
   void symbol_link_word(int source_segment, int source_offset, const char* name, LinkedWord::Kind kind);
   void symbol_link_offset(int source_segment, int source_offset, const char* name);
   Function& get_function_at_label(int label_id);
-  std::string get_label_name(int label_id) const;
+  const std::string& get_label_name(int label_id) const;
+  int intern_symbol(const std::string& name);
+  int get_symbol_id(const std::string& name) const;
+  const std::string& get_symbol_name(int symbol_id) const;
   uint32_t set_ordered_label_names();
   void find_code();
-  std::string print_words();
+  void print_words(BufferedFileWriter& out);
   void find_functions();
+  void disassemble_function(int seg, Function& function);
   void disassemble_functions();
+  void release_instructions();
   void process_fp_relative_links();
   std::string print_scripts();
-  std::string print_disassembly();
+  std::vector<Form*> find_scripts(Arena& arena);
+  void print_disassembly(BufferedFileWriter& out);
   bool has_any_functions();
   void append_word_to_string(std::string& dest, const LinkedWord& word) const;
+  void print_word(BufferedFileWriter& out, const LinkedWord& word) const;
+  void write_to(BinaryWriter& out) const;
+  void read_from(BinaryReader& in);
 
   struct Stats {
     uint32_t total_code_bytes = 0;
@@ -111,19 +127,39 @@ public:
   } stats;
 
   int segments = 0;
-  std::vector<std::vector<LinkedWord>> words_by_seg;
+  std::vector<SegmentWords> words_by_seg;
   std::vector<uint32_t> offset_of_data_zone_by_seg;
   std::vector<std::vector<Function>> functions_by_seg;
   std::vector<Label> labels;
 
 private:
-  std::shared_ptr<Form> to_form_script(int seg, int word_idx, std::vector<bool>& seen);
-  std::shared_ptr<Form> to_form_script_object(int seg, int byte_idx, std::vector<bool> &seen);
+  void process_fp_relative_links(int seg, Function& function);
+  Form* to_form_script(Arena& arena, int seg, int word_idx, std::vector<bool>& seen);
+  Form* to_form_script_object(Arena& arena, int seg, int byte_idx, std::vector<bool>& seen);
   bool is_empty_list(int seg, int byte_idx);
   bool is_string(int seg, int byte_idx);
   std::string get_goal_string(int seg, int word_idx);
-
+  size_t first_label_at_or_after(int seg, int offset) const;
+  int format_word(char* buff, size_t size, const LinkedWord& word) const;
+  void print_labels_in_word(BufferedFileWriter& out,
+                            int seg,
+                            int word_idx,
+                            size_t* label_cursor) const;
+
+  // label ids by offset, used to find labels until finish_labels() is called.
   std::vector<std::unordered_map<int, int>> label_per_seg_by_offset;
+
+  struct LabelAtOffset {
+    int offset;
+    int label_id;
+  };
+  // after finish_labels() is called, all labels in each segment, sorted by offset.
+  std::vector<std::vector<LabelAtOffset>> labels_by_seg;
+  bool labels_finished = false;
+
+  // names of all symbols linked in this file, indexed by the symbol id stored in LinkedWord.
+  std::vector<std::string> symbol_names;
+  std::unordered_map<std::string, int> symbol_ids_by_name;
 };
 
 
@@ -81,13 +81,14 @@ enum class SymbolLinkKind {
  * Handle symbol links for a single symbol in a V2/V4 object file.
  */
 static uint32_t c_symlink2(LinkedObjectFile& f,
-                           const std::vector<uint8_t>& data,
+                           TypeInfo& type_info,
+                           const ByteSpan& data,
                            uint32_t code_ptr_offset,
                            uint32_t link_ptr_offset,
                            SymbolLinkKind kind,
                            const char* name,
                            int seg_id) {
-  get_type_info().inform_symbol_with_no_type_info(name);
+  type_info.inform_symbol_with_no_type_info(name);
   auto initial_offset = code_ptr_offset;
   do {
     auto table_value = data.at(link_ptr_offset);
@@ -130,7 +131,7 @@ static uint32_t c_symlink2(LinkedObjectFile& f,
           word_kind = LinkedWord::EMPTY_PTR;
           break;
         case SymbolLinkKind::TYPE:
-          get_type_info().inform_type(name);
+          type_info.inform_type(name);
           word_kind = LinkedWord::TYPE_PTR;
           break;
         default:
@@ -157,13 +158,14 @@ static uint32_t c_symlink2(LinkedObjectFile& f,
  * Handle symbol links for a single symbol in a V3 object file.
  */
 static uint32_t c_symlink3(LinkedObjectFile& f,
-                           const std::vector<uint8_t>& data,
+                           TypeInfo& type_info,
+                           const ByteSpan& data,
                            uint32_t code_ptr,
                            uint32_t link_ptr,
                            SymbolLinkKind kind,
                            const char* name,
                            int seg) {
-  get_type_info().inform_symbol_with_no_type_info(name);
+  type_info.inform_symbol_with_no_type_info(name);
   auto initial_offset = code_ptr;
   do {
     // seek, with a variable length encoding that sucks.
@@ -187,7 +189,7 @@ static uint32_t c_symlink3(LinkedObjectFile& f,
           word_kind = LinkedWord::EMPTY_PTR;
           break;
         case SymbolLinkKind::TYPE:
-          get_type_info().inform_type(name);
+          type_info.inform_type(name);
           word_kind = LinkedWord::TYPE_PTR;
           break;
         default:
@@ -223,7 +225,8 @@ static uint32_t align16(uint32_t in) {
  * -----------------------------------------------
  */
 static void link_v4(LinkedObjectFile& f,
-                    const std::vector<uint8_t>& data,
+                    TypeInfo& type_info,
+                    const ByteSpan& data,
                     const std::string& name) {
   // read the V4 header to find where the link data really is
   const auto* header = (const LinkHeaderV4*)&data.at(0);
@@ -242,9 +245,7 @@ static void link_v4(LinkedObjectFile& f,
       &data.at(code_offset + code_size);  // safe because link data is after code.
   assert(((code_end - code_start) % 4) == 0);
   f.set_segment_count(1);
-  for (auto x = code_start; x < code_end; x += 4) {
-    f.push_back_word_to_segment(*((const uint32_t*)x), 0);
-  }
+  f.set_segment_words(0, code_start, (code_end - code_start) / 4);
 
   // read v2 header after the code
   const uint8_t* link_data = &data.at(link_data_offset);
@@ -359,7 +360,8 @@ static void link_v4(LinkedObjectFile& f,
 
       link_ptr_offset += strlen(s_name) + 1;
       f.stats.total_v2_symbol_count++;
-      link_ptr_offset = c_symlink2(f, data, code_offset, link_ptr_offset, kind, s_name, 0);
+      link_ptr_offset =
+          c_symlink2(f, type_info, data, code_offset, link_ptr_offset, kind, s_name, 0);
       if (data.at(link_ptr_offset) == 0)
         break;
     }
@@ -384,7 +386,8 @@ static void assert_string_empty_after(const char* str, int size) {
 }
 
 static void link_v5(LinkedObjectFile& f,
-                    const std::vector<uint8_t>& data,
+                    TypeInfo& type_info,
+                    const ByteSpan& data,
                     const std::string& name) {
   auto header = (const LinkHeaderV5*)(&data.at(0));
   if (header->n_segments == 1) {
@@ -462,9 +465,7 @@ static void link_v5(LinkedObjectFile& f,
 
     auto code_start = (const uint32_t*)(&data.at(data_ptr + 4));
     auto code_end = ((const uint32_t*)(&data.at(data_ptr + segment_size))) + 1;
-    for (auto x = code_start; x < code_end; x++) {
-      f.push_back_word_to_segment(*((const uint32_t*)x), seg_id);
-    }
+    f.set_segment_words(seg_id, (const uint8_t*)code_start, code_end - code_start);
     bool fixing = false;
 
     if (data.at(link_ptr)) {
@@ -539,10 +540,10 @@ static void link_v5(LinkedObjectFile& f,
           // todo segment data offsets...
 
           if (std::string("_empty_") == sname) {
-            link_ptr = c_symlink2(f, data, segment_data_offsets[seg_id], link_ptr,
+            link_ptr = c_symlink2(f, type_info, data, segment_data_offsets[seg_id], link_ptr,
                                   SymbolLinkKind::EMPTY_LIST, sname, seg_id);
           } else {
-            link_ptr = c_symlink2(f, data, segment_data_offsets[seg_id], link_ptr,
+            link_ptr = c_symlink2(f, type_info, data, segment_data_offsets[seg_id], link_ptr,
                                   SymbolLinkKind::SYMBOL, sname, seg_id);
           }
         } else if ((reloc & 0x3f) == 0x3f) {
@@ -556,7 +557,7 @@ static void link_v5(LinkedObjectFile& f,
           link_ptr += 2;  // ghidra misses some aliasing here and would have you think this is +1!
           const char* sname = (const char*)(&data.at(link_ptr));
           link_ptr += strlen(sname) + 1;
-          link_ptr = c_symlink2(f, data, segment_data_offsets[seg_id], link_ptr,
+          link_ptr = c_symlink2(f, type_info, data, segment_data_offsets[seg_id], link_ptr,
                                 SymbolLinkKind::TYPE, sname, seg_id);
         }
 
@@ -586,7 +587,8 @@ static void link_v5(LinkedObjectFile& f,
 }
 
 static void link_v3(LinkedObjectFile& f,
-                    const std::vector<uint8_t>& data,
+                    TypeInfo& type_info,
+                    const ByteSpan& data,
                     const std::string& name) {
   auto header = (const LinkHeaderV3*)(&data.at(0));
   assert(name == header->name);
@@ -662,9 +664,7 @@ static void link_v3(LinkedObjectFile& f,
 
     auto code_start = (const uint32_t*)(&data.at(data_ptr + 4));
     auto code_end = ((const uint32_t*)(&data.at(data_ptr + segment_size))) + 1;
-    for (auto x = code_start; x < code_end; x++) {
-      f.push_back_word_to_segment(*((const uint32_t*)x), seg_id);
-    }
+    f.set_segment_words(seg_id, (const uint8_t*)code_start, code_end - code_start);
     bool fixing = false;
 
     if (data.at(link_ptr)) {
@@ -740,7 +740,7 @@ static void link_v3(LinkedObjectFile& f,
         // methods todo
 
         s_name = (const char*)(&data.at(link_ptr));
-        get_type_info().inform_type_method_count(s_name, reloc & 0x7f);
+        type_info.inform_type_method_count(s_name, reloc & 0x7f);
         kind = SymbolLinkKind::TYPE;
       }
 
@@ -751,7 +751,7 @@ static void link_v3(LinkedObjectFile& f,
 
       link_ptr += strlen(s_name) + 1;
       f.stats.v3_symbol_count++;
-      link_ptr = c_symlink3(f, data, base_ptr, link_ptr, kind, s_name, seg_id);
+      link_ptr = c_symlink3(f, type_info, data, base_ptr, link_ptr, kind, s_name, seg_id);
     }
     segment_link_ends[seg_id] = link_ptr;
   }
@@ -775,23 +775,27 @@ static void link_v3(LinkedObjectFile& f,
 
 /*!
  * Main function to generate LinkedObjectFiles from raw object data.
+ * Symbols and types found while linking are reported to type_info.
  */
-LinkedObjectFile to_linked_object_file(const std::vector<uint8_t>& data, const std::string& name) {
+LinkedObjectFile to_linked_object_file(const ByteSpan& data,
+                                       const std::string& name,
+                                       TypeInfo& type_info) {
   LinkedObjectFile result;
   const auto* header = (const LinkHeaderCommon*)&data.at(0);
 
   // use appropriate linker
   if (header->version == 3) {
     assert(header->type_tag == 0);
-    link_v3(result, data, name);
+    link_v3(result, type_info, data, name);
   } else if (header->version == 4) {
     assert(header->type_tag == 0xffffffff);
-    link_v4(result, data, name);
+    link_v4(result, type_info, data, name);
   } else if (header->version == 5) {
-    link_v5(result, data, name);
+    link_v5(result, type_info, data, name);
   } else {
     assert(false);
   }
 
+  result.finish_linking();
   return result;
 }
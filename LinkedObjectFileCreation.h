@@ -8,7 +8,11 @@
 #define NEXT_LINKEDOBJECTFILECREATION_H
 
 #include "LinkedObjectFile.h"
+#include "TypeSystem/TypeInfo.h"
+#include "util/ByteSpan.h"
 
-LinkedObjectFile to_linked_object_file(const std::vector<uint8_t>& data, const std::string& name);
+LinkedObjectFile to_linked_object_file(const ByteSpan& data,
+                                       const std::string& name,
+                                       TypeInfo& type_info);
 
 #endif //NEXT_LINKEDOBJECTFILECREATION_H
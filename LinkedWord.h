@@ -6,14 +6,20 @@
 #ifndef JAK2_DISASSEMBLER_LINKEDWORD_H
 #define JAK2_DISASSEMBLER_LINKEDWORD_H
 
+#include <cassert>
 #include <cstdint>
-#include <string>
 
+/*!
+ * A word, plus what it links to. Packed into 8 bytes, as every word of every object file is stored
+ * like this. The link is either a label id (PTR, HI_PTR, LO_PTR) or a symbol id (SYM_PTR,
+ * EMPTY_PTR, SYM_OFFSET, TYPE_PTR), which is an index into the symbol names of the
+ * LinkedObjectFile.
+ */
 class LinkedWord {
  public:
   explicit LinkedWord(uint32_t _data) : data(_data) {}
 
-  enum Kind {
+  enum Kind : uint8_t {
     PLAIN_DATA,  // just plain data
     PTR,         // pointer to a location
     HI_PTR,      // lower 16-bits of this data are the upper 16 bits of a pointer
@@ -22,12 +28,47 @@ class LinkedWord {
     EMPTY_PTR,   // this is a pointer to the empty list
     SYM_OFFSET,  // this is an offset of a symbol in the symbol table
     TYPE_PTR     // this is a pointer to a type
-  } kind = PLAIN_DATA;
+  };
 
   uint32_t data = 0;
 
-  int label_id = -1;
-  std::string symbol_name;
+  Kind kind() const { return Kind(m_link & 0xff); }
+
+  bool has_label() const { return kind() == PTR || kind() == HI_PTR || kind() == LO_PTR; }
+
+  bool has_symbol() const {
+    return kind() == SYM_PTR || kind() == EMPTY_PTR || kind() == SYM_OFFSET || kind() == TYPE_PTR;
+  }
+
+  int label_id() const {
+    assert(has_label());
+    return int(m_link >> 8);
+  }
+
+  int symbol_id() const {
+    assert(has_symbol());
+    return int(m_link >> 8);
+  }
+
+  void set_to_label(Kind link_kind, int id) {
+    set_link(link_kind, id);
+    assert(has_label());
+  }
+
+  void set_to_symbol(Kind link_kind, int id) {
+    set_link(link_kind, id);
+    assert(has_symbol());
+  }
+
+ private:
+  void set_link(Kind link_kind, int id) {
+    assert(id >= 0 && id < (1 << 24));
+    m_link = uint32_t(link_kind) | (uint32_t(id) << 8);
+  }
+
+  uint32_t m_link = PLAIN_DATA;  // kind in the low 8 bits, label/symbol id in the upper 24.
 };
 
+static_assert(sizeof(LinkedWord) == 8, "LinkedWord should be packed");
+
 #endif  // JAK2_DISASSEMBLER_LINKEDWORD_H
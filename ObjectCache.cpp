@@ -0,0 +1,169 @@
+/*!
+ * @file ObjectCache.cpp
+ * A directory of cached LinkedObjectFiles, so unchanged object files don't have to be linked and
+ * disassembled again on the next run.
+ */
+
+#include "ObjectCache.h"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include "Disasm/InstructionDecode.h"
+#include "LinkedObjectFile.h"
+#include "TypeSystem/TypeInfo.h"
+#include "config.h"
+#include "util/BinaryReader.h"
+#include "util/BinaryWriter.h"
+#include "util/FileIO.h"
+#include "util/MappedFile.h"
+
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+
+namespace {
+constexpr char CACHE_MAGIC[8] = {'J', 'D', 'O', 'B', 'J', 'C', 'C', 'H'};
+
+/*!
+ * At the start of each cache file. An entry is only used if all of this matches.
+ * The payload (LinkedObjectFile, then TypeInfo) follows.
+ */
+struct CacheFileHeader {
+  char magic[8];
+  uint32_t cache_version;
+  uint32_t decoder_version;
+  int32_t game_version;
+  uint32_t obj_size;
+  uint32_t obj_crc;
+  uint32_t payload_size;
+  uint64_t obj_hash;
+  uint32_t payload_crc;
+  uint32_t pad;
+};
+
+CacheFileHeader make_header(const ObjectCacheKey& key) {
+  CacheFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header.cache_version = OBJECT_CACHE_VERSION;
+  header.decoder_version = DECODER_VERSION;
+  header.game_version = get_config().game_version;
+  header.obj_size = key.size;
+  header.obj_crc = key.crc;
+  header.obj_hash = key.hash;
+  return header;
+}
+}  // namespace
+
+/*!
+ * Use the given directory for the cache. It's created if it doesn't exist.
+ */
+ObjectCache::ObjectCache(const std::string& dir) : m_dir(dir) {
+#ifdef __linux__
+  struct stat st = {};
+  if (stat(dir.c_str(), &st) != 0) {
+    if (mkdir(dir.c_str(), 0755) != 0) {
+      throw std::runtime_error("Cache directory " + dir + " cannot be created");
+    }
+  } else if (!S_ISDIR(st.st_mode)) {
+    throw std::runtime_error("Cache directory " + dir + " is not a directory");
+  }
+#endif
+}
+
+/*!
+ * Get the key for an object file. crc should be the crc32 of the data.
+ */
+ObjectCacheKey ObjectCache::make_key(const std::string& name, ByteSpan data, uint32_t crc) {
+  ObjectCacheKey key;
+  key.name = name;
+  key.size = data.size();
+  key.crc = crc;
+  key.hash = hash64(data.data(), data.size());
+  return key;
+}
+
+/*!
+ * Get the file name for an entry. Entries for other game versions or decoders have the same name,
+ * and are replaced when saving.
+ */
+std::string ObjectCache::get_path(const ObjectCacheKey& key) const {
+  char suffix[64];
+  sprintf(suffix, "-%08x-%016llx.lobj", key.crc, (unsigned long long)key.hash);
+  return combine_path(m_dir, key.name + suffix);
+}
+
+/*!
+ * Try to load an object file from the cache. On success, file is replaced by the cached one, and
+ * type_info is informed of everything found while linking it. Returns false if there's no usable
+ * entry, and leaves file and type_info alone.
+ */
+bool ObjectCache::load(const ObjectCacheKey& key, LinkedObjectFile& file, TypeInfo& type_info) {
+  std::unique_ptr<MappedFile> entry;
+  try {
+    entry = std::make_unique<MappedFile>(get_path(key));
+  } catch (std::runtime_error&) {
+    stats.misses++;
+    return false;
+  }
+
+  auto expected = make_header(key);
+  CacheFileHeader header;
+  if (entry->size() < sizeof(header)) {
+    stats.misses++;
+    return false;
+  }
+  memcpy(&header, entry->data(), sizeof(header));
+  auto payload = entry->data() + sizeof(header);
+  expected.payload_size = header.payload_size;
+  expected.payload_crc = header.payload_crc;
+  if (memcmp(&header, &expected, sizeof(header)) != 0 ||
+      entry->size() != sizeof(header) + header.payload_size ||
+      crc32(payload, header.payload_size) != header.payload_crc) {
+    stats.misses++;
+    return false;
+  }
+
+  LinkedObjectFile cached_file;
+  TypeInfo cached_type_info;
+  cached_type_info.defer_method_count_checks();
+  BinaryReader reader(payload, header.payload_size);
+  cached_file.read_from(reader);
+  cached_type_info.read_from(reader);
+  assert(reader.bytes_left() == 0);
+
+  file = std::move(cached_file);
+  type_info.merge(cached_type_info);
+  stats.hits++;
+  stats.loaded_bytes += entry->size();
+  return true;
+}
+
+/*!
+ * Save an object file to the cache. It must be fully disassembled, and type_info must contain
+ * only what was found while linking it.
+ */
+void ObjectCache::save(const ObjectCacheKey& key,
+                       const LinkedObjectFile& file,
+                       const TypeInfo& type_info) {
+  BinaryWriter out;
+  out.add(CacheFileHeader());  // filled in once the payload is done
+  file.write_to(out);
+  type_info.write_to(out);
+
+  auto header = make_header(key);
+  header.payload_size = out.size() - sizeof(header);
+  header.payload_crc = crc32(out.data() + sizeof(header), header.payload_size);
+  out.set(0, header);
+
+  // write to a temporary file first, so an interrupted run never leaves a partial entry.
+  auto path = get_path(key);
+  auto temp_path = path + ".tmp";
+  write_binary_file(temp_path, out.data(), out.size());
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    throw std::runtime_error("Failed to rename " + temp_path);
+  }
+  stats.saved++;
+  stats.saved_bytes += out.size();
+}
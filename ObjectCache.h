@@ -0,0 +1,58 @@
+/*!
+ * @file ObjectCache.h
+ * A directory of cached LinkedObjectFiles, so unchanged object files don't have to be linked and
+ * disassembled again on the next run.
+ */
+
+#ifndef JAK_DISASSEMBLER_OBJECTCACHE_H
+#define JAK_DISASSEMBLER_OBJECTCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "util/ByteSpan.h"
+
+class LinkedObjectFile;
+class TypeInfo;
+
+// Bump this when linking, find_code, find_functions or process_fp_relative_links change their
+// results, or when the cache file layout changes.
+constexpr uint32_t OBJECT_CACHE_VERSION = 4;
+
+/*!
+ * Identifies the contents of an object file in the cache.
+ */
+struct ObjectCacheKey {
+  std::string name;
+  uint32_t size = 0;
+  uint32_t crc = 0;
+  uint64_t hash = 0;
+};
+
+/*!
+ * Stores the result of linking, finding code and disassembling an object file (including all the
+ * symbols and types reported to the TypeInfo while linking), as one file per object.
+ * The entries depend on the game version and the decoder, so those are part of the key.
+ * Loading and saving are safe to do from multiple threads at once.
+ */
+class ObjectCache {
+ public:
+  explicit ObjectCache(const std::string& dir);
+  static ObjectCacheKey make_key(const std::string& name, ByteSpan data, uint32_t crc);
+  bool load(const ObjectCacheKey& key, LinkedObjectFile& file, TypeInfo& type_info);
+  void save(const ObjectCacheKey& key, const LinkedObjectFile& file, const TypeInfo& type_info);
+
+  struct Stats {
+    std::atomic<uint32_t> hits = {0};
+    std::atomic<uint32_t> misses = {0};
+    std::atomic<uint32_t> saved = {0};
+    std::atomic<uint64_t> loaded_bytes = {0};
+    std::atomic<uint64_t> saved_bytes = {0};
+  } stats;
+
+ private:
+  std::string get_path(const ObjectCacheKey& key) const;
+  std::string m_dir;
+};
+
+#endif  // JAK_DISASSEMBLER_OBJECTCACHE_H
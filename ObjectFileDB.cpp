@@ -7,15 +7,23 @@
 
 #include "ObjectFileDB.h"
 #include <algorithm>
+#include <atomic>
 #include <cstring>
+#include "Disasm/InstructionDecode.h"
 #include "LinkedObjectFileCreation.h"
 #include "config.h"
 #include "third-party/minilzo/minilzo.h"
+#include "util/AllocationCounter.h"
 #include "util/BinaryReader.h"
+#include "util/BufferedFileWriter.h"
 #include "util/FileIO.h"
 #include "util/Timer.h"
 #include "Function/BasicBlocks.h"
 
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
 /*!
  * Get a unique name for this object file.
  */
@@ -23,15 +31,49 @@ std::string ObjectFileRecord::to_unique_name() const {
   return name + "-v" + std::to_string(version);
 }
 
+namespace {
+/*!
+ * Get the peak resident memory of this process, or 0 if we can't.
+ */
+uint64_t get_peak_rss_bytes() {
+#ifdef __linux__
+  struct rusage usage = {};
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    return uint64_t(usage.ru_maxrss) * 1024;  // kB
+  }
+#endif
+  return 0;
+}
+}  // namespace
+
+/*!
+ * Get the total time spent on this object in all stages that record their cost.
+ */
+int64_t ObjectFileData::total_cost_ns() const {
+  int64_t total = 0;
+  for (auto& cost : costs) {
+    total += cost.ns;
+  }
+  return total;
+}
+
 /*!
  * Build an object file DB for the given list of DGOs.
  */
-ObjectFileDB::ObjectFileDB(const std::vector<std::string>& _dgos) {
+ObjectFileDB::ObjectFileDB(const std::vector<std::string>& _dgos, int jobs) : pool(jobs) {
+  ScopedStage profile_stage("load_dgos");
   Timer timer;
 
-  printf("- Initializing ObjectFileDB...\n");
-  for (auto& dgo : _dgos) {
-    get_objs_from_dgo(dgo);
+  printf("- Initializing ObjectFileDB (%d threads)...\n", pool.size());
+  // DGOs are loaded in batches, with the work of all DGOs in a batch spread over the pool. The
+  // objects are then added one DGO at a time, in the order they were given, so the object versions
+  // are always the same. Each DGO is freed as soon as its objects are added.
+  size_t next_dgo = 0;
+  while (next_dgo < _dgos.size()) {
+    auto batch = load_dgos(_dgos, next_dgo);
+    for (auto& dgo : batch) {
+      add_objs_from_dgo(dgo);
+    }
   }
 
   printf("ObjectFileDB Initialized:\n");
@@ -40,10 +82,36 @@ ObjectFileDB::ObjectFileDB(const std::vector<std::string>& _dgos) {
   printf(" total objs: %d\n", stats.total_obj_files);
   printf(" unique objs: %d\n", stats.unique_obj_files);
   printf(" unique data: %d bytes\n", stats.unique_obj_bytes);
+  printf(" mapped data: %.3f MB\n", stats.mapped_bytes / (double)(1u << 20u));
+  printf(" owned data: %.3f MB\n", stats.owned_bytes / (double)(1u << 20u));
+  printf(" copies avoided: %.3f MB\n", stats.copies_avoided_bytes / (double)(1u << 20u));
+  printf(" peak rss: %.3f MB\n", get_peak_rss_bytes() / (double)(1u << 20u));
+  if (stats.decompressed_bytes) {
+    printf(" decompressed %.3f MB in %.1f ms (%.3f MB/sec)\n",
+           stats.decompressed_bytes / (double)(1u << 20u), 1000. * stats.decompress_seconds,
+           stats.decompressed_bytes / ((1u << 20u) * stats.decompress_seconds));
+  }
+  if (stats.hashed_bytes) {
+    printf(" hashed %.3f MB in %.1f ms (%.3f MB/sec)\n", stats.hashed_bytes / (double)(1u << 20u),
+           1000. * stats.hash_seconds, stats.hashed_bytes / ((1u << 20u) * stats.hash_seconds));
+  }
   printf(" total %.1f ms (%.3f MB/sec, %.3f obj/sec)\n", timer.getMs(),
          stats.total_dgo_bytes / ((1u << 20u) * timer.getSeconds()),
          stats.total_obj_files / timer.getSeconds());
   printf("\n");
+
+  auto& profiler = get_profiler();
+  profiler.add_counter("dgos", _dgos.size());
+  profiler.add_counter("dgo_bytes", stats.total_dgo_bytes);
+  profiler.add_counter("objs", stats.total_obj_files);
+  profiler.add_counter("unique_objs", stats.unique_obj_files);
+  profiler.add_counter("unique_obj_bytes", stats.unique_obj_bytes);
+  profiler.add_counter("mapped_bytes", stats.mapped_bytes);
+  profiler.add_counter("owned_bytes", stats.owned_bytes);
+  profiler.add_counter("decompressed_bytes", stats.decompressed_bytes);
+  profiler.add_counter("decompress_ms", 1000. * stats.decompress_seconds);
+  profiler.add_counter("hashed_bytes", stats.hashed_bytes);
+  profiler.add_counter("hash_ms", 1000. * stats.hash_seconds);
 }
 
 // Header for a DGO file
@@ -69,122 +137,291 @@ void assert_string_empty_after(const char* str, int size) {
 }  // namespace
 
 constexpr int MAX_CHUNK_SIZE = 0x8000;
+// DGOs are loaded in batches of about this many bytes (after decompression), so the work of
+// several DGOs can be spread over the pool without holding every DGO in memory at once.
+constexpr size_t DGO_BATCH_BYTES = 256u << 20u;
+
+namespace {
 /*!
- * Load the objects stored in the given DGO into the ObjectFileDB
+ * A chunk of a compressed (oZlB) DGO, and where it decompresses to.
  */
-void ObjectFileDB::get_objs_from_dgo(const std::string& filename) {
-  auto dgo_data = read_binary_file(filename);
-  stats.total_dgo_bytes += dgo_data.size();
+struct DgoChunk {
+  const uint8_t* src;
+  uint32_t size;
+  uint8_t* dst;
+  size_t expected_size;
+};
 
+bool is_compressed_dgo(ByteSpan data) {
   const char jak2_header[] = "oZlB";
-  bool is_jak2 = true;
   for (int i = 0; i < 4; i++) {
-    if (jak2_header[i] != dgo_data[i]) {
-      is_jak2 = false;
+    if (jak2_header[i] != data.at(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ * Get the size of a compressed DGO once it's decompressed.
+ */
+uint32_t decompressed_dgo_size(ByteSpan compressed_data) {
+  BinaryReader reader(compressed_data.data(), compressed_data.size());
+  // seek past oZlB
+  reader.ffwd(4);
+  return reader.read<uint32_t>();
+}
+
+/*!
+ * Find the chunks of a compressed (oZlB) DGO and add them to chunks. The data is split into chunks
+ * which each decompress to MAX_CHUNK_SIZE bytes (except the last), so they can all be decompressed
+ * in parallel into the returned buffer.
+ */
+std::unique_ptr<std::vector<uint8_t>> find_dgo_chunks(ByteSpan compressed_data,
+                                                      std::vector<DgoChunk>& chunks) {
+  BinaryReader compressed_reader(compressed_data.data(), compressed_data.size());
+  // seek past oZlB
+  compressed_reader.ffwd(4);
+  auto decompressed_size = compressed_reader.read<uint32_t>();
+  auto result = std::make_unique<std::vector<uint8_t>>(decompressed_size);
+
+  size_t output_offset = 0;
+  while (true) {
+    // seek past alignment bytes and read the next chunk size
+    uint32_t chunk_size = 0;
+    while (!chunk_size) {
+      chunk_size = compressed_reader.read<uint32_t>();
+    }
+
+    size_t expected_size = std::min(size_t(MAX_CHUNK_SIZE), decompressed_size - output_offset);
+    chunks.push_back(
+        {compressed_reader.here(), chunk_size, result->data() + output_offset, expected_size});
+    // nope - sometimes chunk_size is bigger than MAX, but we should still use max.
+    compressed_reader.ffwd(chunk_size < MAX_CHUNK_SIZE ? chunk_size : MAX_CHUNK_SIZE);
+    output_offset += MAX_CHUNK_SIZE;
+
+    if (output_offset >= decompressed_size)
+      break;
+    while (compressed_reader.get_seek() % 4) {
+      compressed_reader.ffwd(1);
     }
   }
 
-  if (is_jak2) {
+  return result;
+}
+
+void decompress_dgo_chunk(const DgoChunk& chunk) {
+  if (chunk.size < MAX_CHUNK_SIZE) {
+    lzo_uint bytes_written = chunk.expected_size;
+    auto lzo_rv =
+        lzo1x_decompress_safe(chunk.src, chunk.size, chunk.dst, &bytes_written, nullptr);
+    assert(lzo_rv == LZO_E_OK);
+    // all chunks but the last must fill up an entire MAX_CHUNK_SIZE.
+    assert(bytes_written == chunk.expected_size);
+  } else {
+    memcpy(chunk.dst, chunk.src, chunk.expected_size);
+  }
+}
+}  // namespace
+
+/*!
+ * Read the next batch of DGO files, starting at filenames[next_dgo], and find the objects inside of
+ * them. next_dgo is advanced past the batch. The chunks of all compressed DGOs in the batch are
+ * decompressed in one parallel loop, then all of their objects are hashed in another, so small DGOs
+ * don't leave threads idle. Adds the time taken to the stats, but doesn't add any objects.
+ */
+std::vector<ObjectFileDB::LoadedDgo> ObjectFileDB::load_dgos(
+    const std::vector<std::string>& filenames,
+    size_t& next_dgo) {
+  std::vector<LoadedDgo> result;
+  std::vector<DgoChunk> chunks;
+  size_t batch_bytes = 0;
+  while (next_dgo < filenames.size() && (result.empty() || batch_bytes < DGO_BATCH_BYTES)) {
+    LoadedDgo dgo;
+    dgo.name = base_name(filenames[next_dgo]);
+    dgo.file = std::make_unique<MappedFile>(filenames[next_dgo]);
+    auto dgo_data = dgo.file->span();
+    if (is_compressed_dgo(dgo_data)) {
+      batch_bytes += decompressed_dgo_size(dgo_data);
+      dgo.decompressed = find_dgo_chunks(dgo_data, chunks);
+    } else {
+      batch_bytes += dgo_data.size();
+    }
+    result.push_back(std::move(dgo));
+    next_dgo++;
+  }
+
+  if (!chunks.empty()) {
     if (lzo_init() != LZO_E_OK) {
       assert(false);
     }
-    BinaryReader compressed_reader(dgo_data);
-    // seek past oZlB
-    compressed_reader.ffwd(4);
-    auto decompressed_size = compressed_reader.read<uint32_t>();
-    std::vector<uint8_t> decompressed_data;
-    decompressed_data.resize(decompressed_size);
-    size_t output_offset = 0;
-    while (true) {
-      // seek past alignment bytes and read the next chunk size
-      uint32_t chunk_size = 0;
-      while (!chunk_size) {
-        chunk_size = compressed_reader.read<uint32_t>();
-      }
+    Timer decompress_timer;
+    pool.parallel_for(chunks.size(), [&](size_t idx, int) { decompress_dgo_chunk(chunks[idx]); });
+    stats.decompress_seconds += decompress_timer.getSeconds();
+  }
 
-      if (chunk_size < MAX_CHUNK_SIZE) {
-        lzo_uint bytes_written;
-        auto lzo_rv =
-            lzo1x_decompress(compressed_reader.here(), chunk_size,
-                             decompressed_data.data() + output_offset, &bytes_written, nullptr);
-        assert(lzo_rv == LZO_E_OK);
-        compressed_reader.ffwd(chunk_size);
-        output_offset += bytes_written;
-      } else {
-        // nope - sometimes chunk_size is bigger than MAX, but we should still use max.
-        //        assert(chunk_size == MAX_CHUNK_SIZE);
-        memcpy(decompressed_data.data() + output_offset, compressed_reader.here(), MAX_CHUNK_SIZE);
-        compressed_reader.ffwd(MAX_CHUNK_SIZE);
-        output_offset += MAX_CHUNK_SIZE;
-      }
+  // get all obj files...
+  struct ObjId {
+    size_t dgo;
+    size_t obj;
+  };
+  std::vector<ObjId> objs;
+  for (size_t dgo_idx = 0; dgo_idx < result.size(); dgo_idx++) {
+    auto& dgo = result[dgo_idx];
+    auto dgo_data = dgo.decompressed ? ByteSpan(*dgo.decompressed) : dgo.file->span();
+    BinaryReader reader(dgo_data.data(), dgo_data.size());
+    auto header = reader.read<DgoHeader>();
 
-      if (output_offset >= decompressed_size)
-        break;
-      while (compressed_reader.get_seek() % 4) {
-        compressed_reader.ffwd(1);
-      }
+    assert(header.name == dgo.name);
+    assert_string_empty_after(header.name, 60);
+
+    for (uint32_t i = 0; i < header.size; i++) {
+      auto obj_header = reader.read<DgoHeader>();
+      assert(reader.bytes_left() >= obj_header.size);
+      assert_string_empty_after(obj_header.name, 60);
+
+      LoadedDgo::Obj obj;
+      obj.name = obj_header.name;
+      obj.data = ByteSpan(reader.here(), obj_header.size);
+      objs.push_back({dgo_idx, dgo.objs.size()});
+      dgo.objs.push_back(std::move(obj));
+      reader.ffwd(obj_header.size);
     }
-    dgo_data = decompressed_data;
+
+    // check we're at the end
+    assert(0 == reader.bytes_left());
   }
 
-  BinaryReader reader(dgo_data);
-  auto header = reader.read<DgoHeader>();
+  Timer hash_timer;
+  pool.parallel_for(objs.size(), [&](size_t idx, int) {
+    auto& obj = result[objs[idx].dgo].objs[objs[idx].obj];
+    obj.hash = crc32(obj.data.data(), obj.data.size());
+  });
+  stats.hash_seconds += hash_timer.getSeconds();
+  return result;
+}
 
-  auto dgo_base_name = base_name(filename);
-  assert(header.name == dgo_base_name);
-  assert_string_empty_after(header.name, 60);
+/*!
+ * Add the objects of a loaded DGO to the ObjectFileDB, and keep around the data of any new ones.
+ */
+void ObjectFileDB::add_objs_from_dgo(LoadedDgo& dgo) {
+  auto file_size = dgo.file->span().size();
+  stats.total_dgo_bytes += file_size;
+  // the old loader read the whole file into a buffer.
+  stats.copies_avoided_bytes += file_size;
+  if (dgo.decompressed) {
+    stats.decompressed_bytes += dgo.decompressed->size();
+    // the old loader made a second copy of the decompressed data.
+    stats.copies_avoided_bytes += dgo.decompressed->size();
+  }
 
-  // get all obj files...
-  for (uint32_t i = 0; i < header.size; i++) {
-    auto obj_header = reader.read<DgoHeader>();
-    assert(reader.bytes_left() >= obj_header.size);
-    assert_string_empty_after(obj_header.name, 60);
+  std::vector<std::pair<std::string, int>> new_objs;  // name, version
+  uint64_t new_obj_bytes = 0;
+  for (auto& obj : dgo.objs) {
+    stats.hashed_bytes += obj.data.size();
+    if (add_obj_from_dgo(obj.name, obj.data, obj.hash, dgo.name)) {
+      new_objs.emplace_back(obj.name, obj_files_by_name.at(obj.name).size() - 1);
+      new_obj_bytes += obj.data.size();
+    }
+  }
 
-    add_obj_from_dgo(obj_header.name, reader.here(), obj_header.size, dgo_base_name);
-    reader.ffwd(obj_header.size);
+  // decide where the data of the new objects should live.
+  if (!dgo.decompressed) {
+    // uncompressed: the new objects point directly into the mapped file.
+    if (!new_objs.empty()) {
+      stats.mapped_bytes += new_obj_bytes;
+      stats.copies_avoided_bytes += new_obj_bytes;
+      dgo_mappings.push_back(std::move(dgo.file));
+    }
+  } else if (2 * new_obj_bytes >= dgo.decompressed->size()) {
+    // compressed, and most of it is new: keep the decompressed buffer.
+    stats.owned_bytes += dgo.decompressed->size();
+    stats.copies_avoided_bytes += new_obj_bytes;
+    dgo_buffers.push_back(std::move(dgo.decompressed));
+  } else if (!new_objs.empty()) {
+    // compressed, but mostly duplicates: pack the new objects into a smaller buffer, so we don't
+    // keep the duplicates around.
+    auto packed = std::make_unique<std::vector<uint8_t>>(new_obj_bytes);
+    size_t offset = 0;
+    for (auto& obj_id : new_objs) {
+      auto& obj = obj_files_by_name.at(obj_id.first).at(obj_id.second);
+      memcpy(packed->data() + offset, obj.data.data(), obj.data.size());
+      obj.data = ByteSpan(packed->data() + offset, obj.data.size());
+      offset += obj.data.size();
+    }
+    stats.owned_bytes += packed->size();
+    dgo_buffers.push_back(std::move(packed));
   }
 
-  // check we're at the end
-  assert(0 == reader.bytes_left());
+  // anything we didn't keep is unmapped/freed now.
+  dgo.file.reset();
+  dgo.decompressed.reset();
 }
 
 /*!
- * Add an object file to the ObjectFileDB
+ * Add an object file to the ObjectFileDB. hash is the crc32 of obj_data.
+ * Returns true if it's a new object file. In this case, the ObjectFileData will point to obj_data,
+ * and it's up to the caller to make sure this stays valid.
  */
-void ObjectFileDB::add_obj_from_dgo(const std::string& obj_name,
-                                    uint8_t* obj_data,
-                                    uint32_t obj_size,
+bool ObjectFileDB::add_obj_from_dgo(const std::string& obj_name,
+                                    ByteSpan obj_data,
+                                    uint32_t hash,
                                     const std::string& dgo_name) {
   stats.total_obj_files++;
 
-  auto hash = crc32(obj_data, obj_size);
-
   // first, check to see if we already got it...
-  for (auto& e : obj_files_by_name[obj_name]) {
-    if (e.data.size() == obj_size && e.record.hash == hash) {
+  auto& versions = obj_versions_by_content[{obj_name, uint32_t(obj_data.size()), hash}];
+  auto& existing = obj_files_by_name[obj_name];
+  for (auto version : versions) {
+    auto& e = existing.at(version);
+    // the crc matches, but make sure it's not a collision.
+    if (memcmp(e.data.data(), obj_data.data(), obj_data.size()) == 0) {
       // already got it!
       e.reference_count++;
       auto rec = e.record;
       obj_files_by_dgo[dgo_name].push_back(rec);
-      return;
+      return false;
     }
   }
 
   // nope, have to add a new one.
   ObjectFileData data;
-  data.data.resize(obj_size);
-  memcpy(data.data.data(), obj_data, obj_size);
+  data.data = obj_data;
   data.record.hash = hash;
   data.record.name = obj_name;
-  if (obj_files_by_name[obj_name].empty()) {
+  if (existing.empty()) {
     // if this is the first time we've seen this object file name, add it in the order.
     obj_file_order.push_back(obj_name);
   }
-  data.record.version = obj_files_by_name[obj_name].size();
+  data.record.version = existing.size();
+  versions.push_back(data.record.version);
   obj_files_by_dgo[dgo_name].push_back(data.record);
-  obj_files_by_name[obj_name].emplace_back(std::move(data));
+  existing.emplace_back(std::move(data));
   stats.unique_obj_files++;
-  stats.unique_obj_bytes += obj_size;
+  stats.unique_obj_bytes += obj_data.size();
+  return true;
+}
+
+/*!
+ * Get pointers to all ObjectFileData's, in the same order as for_each_obj.
+ */
+std::vector<ObjectFileData*> ObjectFileDB::get_objs_in_order() {
+  assert(obj_files_by_name.size() == obj_file_order.size());
+  std::vector<ObjectFileData*> result;
+  for (const auto& name : obj_file_order) {
+    for (auto& obj : obj_files_by_name.at(name)) {
+      result.push_back(&obj);
+    }
+  }
+  return result;
+}
+
+/*!
+ * Load linked and disassembled object files from the given directory when possible, and save the
+ * ones we had to process there. Must be done before process_link_data.
+ */
+void ObjectFileDB::enable_cache(const std::string& cache_dir) {
+  cache = std::make_unique<ObjectCache>(cache_dir);
 }
 
 /*!
@@ -210,20 +447,197 @@ std::string ObjectFileDB::generate_dgo_listing() {
   return result;
 }
 
+namespace {
+/*!
+ * Hash of the settings which change the output files for an object, so incremental mode can tell
+ * when everything needs to be written again.
+ */
+uint64_t get_output_settings_hash() {
+  const auto& config = get_config();
+  char buff[256];
+  int len = snprintf(buff, sizeof(buff), "%d %d %d %d %d %d %d %d %d %u %u", config.game_version,
+                     config.write_disassembly, config.write_hexdump, config.write_hexdump_on_v3_only,
+                     config.disassemble_objects_without_functions, config.find_basic_blocks,
+                     config.write_hex_near_instructions, config.write_scripts,
+                     config.write_scripts_per_object, DECODER_VERSION, OBJECT_CACHE_VERSION);
+  return hash64((const uint8_t*)buff, len);
+}
+}  // namespace
+
+/*!
+ * Generate a manifest for incremental mode. This is like the DGO listing, but also has the size
+ * and hashes of each object, and the output settings.
+ */
+std::string ObjectFileDB::generate_dgo_manifest() {
+  std::string result = ";; DGO Manifest\n";
+  char buff[256];
+  sprintf(buff, ";; settings #x%016llx\n\n", (unsigned long long)get_output_settings_hash());
+  result += buff;
+
+  std::vector<std::string> dgo_names;
+  for (auto& kv : obj_files_by_dgo) {
+    dgo_names.push_back(kv.first);
+  }
+  std::sort(dgo_names.begin(), dgo_names.end());
+
+  for (const auto& name : dgo_names) {
+    result += "(\"" + name + "\"\n";
+    for (auto& rec : obj_files_by_dgo[name]) {
+      auto& key = obj_files_by_name.at(rec.name).at(rec.version).content_key;
+      sprintf(buff, " :version %d :size %u :crc #x%08x :hash #x%016llx :scripts %d\n", rec.version,
+              key.size, key.crc, (unsigned long long)key.hash,
+              obj_files_by_name.at(rec.name).at(rec.version).has_scripts);
+      result += "  " + rec.name + buff;
+    }
+    result += "  )\n\n";
+  }
+
+  return result;
+}
+
+/*!
+ * Turn on incremental mode: objects which are the same as in the manifest from the last run into
+ * output_dir aren't analyzed or written again (see find_changed_objects), and files whose content
+ * didn't change aren't touched. Must be done before process_link_data.
+ */
+void ObjectFileDB::enable_incremental(const std::string& output_dir) {
+  incremental = true;
+  auto manifest = read_text_file(combine_path(output_dir, "dgo_manifest.txt"));
+  if (manifest.empty()) {
+    printf("No dgo_manifest.txt from a previous run, everything will be written.\n");
+    return;
+  }
+
+  size_t line_start = 0;
+  while (line_start < manifest.size()) {
+    auto line_end = manifest.find('\n', line_start);
+    if (line_end == std::string::npos) {
+      line_end = manifest.size();
+    }
+    auto line = manifest.substr(line_start, line_end - line_start);
+    line_start = line_end + 1;
+
+    unsigned long long settings = 0;
+    if (sscanf(line.c_str(), ";; settings #x%llx", &settings) == 1) {
+      previous_settings_hash = settings;
+      have_previous_manifest = true;
+      continue;
+    }
+
+    // object lines look like "  name :version 0 :size 123 :crc #x... :hash #x... :scripts 1"
+    char name[128];
+    int version = 0;
+    PreviousObj prev;
+    unsigned long long hash = 0;
+    int had_scripts = 1;  // if a manifest doesn't say, check for the .lisp file to be safe.
+    if (sscanf(line.c_str(), "  %127s :version %d :size %u :crc #x%x :hash #x%llx :scripts %d",
+               name, &version, &prev.key.size, &prev.key.crc, &hash, &had_scripts) >= 5) {
+      prev.key.name = name;
+      prev.key.hash = hash;
+      prev.had_scripts = had_scripts;
+      ObjectFileRecord rec;
+      rec.name = name;
+      rec.version = version;
+      previous_objs[rec.to_unique_name()] = prev;
+    }
+  }
+}
+
+/*!
+ * In incremental mode, find the objects that are exactly the same as in the last run, with the same
+ * settings, and which already have all of their output files. These are skipped by the analysis
+ * and the writers. Call after find_code, as that decides which files an object will have.
+ */
+void ObjectFileDB::find_changed_objects(const std::string& output_dir) {
+  assert(incremental);
+  ScopedStage profile_stage("find_changed_objects");
+  printf("- Finding changed objects...\n");
+  Timer timer;
+
+  const auto& config = get_config();
+  bool same_settings = have_previous_manifest && previous_settings_hash == get_output_settings_hash();
+  std::atomic<uint32_t> unchanged_count = {0};
+  for_each_obj_parallel([&](ObjectFileData& obj) {
+    obj.unchanged = false;
+    if (!same_settings) {
+      return;
+    }
+
+    auto unique_name = obj.record.to_unique_name();
+    auto prev = previous_objs.find(unique_name);
+    if (prev == previous_objs.end() || prev->second.key.size != obj.content_key.size ||
+        prev->second.key.crc != obj.content_key.crc ||
+        prev->second.key.hash != obj.content_key.hash) {
+      return;
+    }
+
+    // if any output files were deleted, write them again.
+    if (config.write_hexdump && (obj.linked_data.segments == 3 || !config.write_hexdump_on_v3_only) &&
+        !file_exists(combine_path(output_dir, unique_name + ".txt"))) {
+      return;
+    }
+    if (config.write_disassembly &&
+        (obj.linked_data.has_any_functions() || config.disassemble_objects_without_functions) &&
+        !file_exists(combine_path(output_dir, unique_name + ".func"))) {
+      return;
+    }
+    if (config.write_scripts && config.write_scripts_per_object && prev->second.had_scripts &&
+        !file_exists(combine_path(output_dir, unique_name + ".lisp"))) {
+      return;
+    }
+
+    // the scripts aren't printed again, so remember whether there were any for the manifest.
+    obj.has_scripts = prev->second.had_scripts;
+    obj.unchanged = true;
+    unchanged_count++;
+  });
+
+  printf("Found changed objects:\n");
+  if (!have_previous_manifest) {
+    printf(" no previous manifest\n");
+  } else if (!same_settings) {
+    printf(" settings changed since the last run\n");
+  }
+  printf(" unchanged: %d / %d\n", unchanged_count.load(), stats.unique_obj_files);
+  printf(" total %.3f ms\n", timer.getMs());
+  printf("\n");
+  get_profiler().add_counter("unchanged_objs", unchanged_count.load());
+}
+
 /*!
  * Process all of the linking data of all objects.
  */
 void ObjectFileDB::process_link_data() {
+  ScopedStage profile_stage("process_link_data");
   printf("- Processing Link Data...\n");
   Timer process_link_timer;
 
   LinkedObjectFile::Stats combined_stats;
 
-  for_each_obj([&](ObjectFileData& obj) {
-    obj.linked_data = to_linked_object_file(obj.data, obj.record.name);
-    combined_stats.add(obj.linked_data.stats);
+  for_each_obj_parallel_with_type_info([&](ObjectFileData& obj, TypeInfo& type_info) {
+    Timer obj_timer;
+    obj.cost(CostStage::LINK).bytes = obj.data.size();
+    if (cache || incremental) {
+      obj.content_key = ObjectCache::make_key(obj.record.name, obj.data, obj.record.hash);
+    }
+
+    if (cache) {
+      if (cache->load(obj.content_key, obj.linked_data, type_info)) {
+        obj.from_cache = true;
+        obj.cost(CostStage::LINK).ns = obj_timer.getNs();
+        return;
+      }
+    }
+
+    obj.linked_data = to_linked_object_file(obj.data, obj.record.name, type_info);
+    if (cache) {
+      obj.link_type_info = std::make_unique<TypeInfo>(type_info);
+    }
+    obj.cost(CostStage::LINK).ns = obj_timer.getNs();
   });
 
+  for_each_obj([&](ObjectFileData& obj) { combined_stats.add(obj.linked_data.stats); });
+
   printf("Processed Link Data:\n");
   printf(" code %d bytes\n", combined_stats.total_code_bytes);
   printf(" v2 code %d bytes\n", combined_stats.total_v2_code_bytes);
@@ -242,30 +656,65 @@ void ObjectFileDB::process_link_data() {
   printf(" v3 symbols %d\n", combined_stats.v3_symbol_count);
   printf(" v3 offset symbol links %d\n", combined_stats.v3_symbol_link_offset);
   printf(" v3 word symbol links %d\n", combined_stats.v3_symbol_link_word);
+  if (cache) {
+    printf(" cache: %d hits, %d misses, loaded %.3f MB\n", cache->stats.hits.load(),
+           cache->stats.misses.load(), cache->stats.loaded_bytes / (double)(1u << 20u));
+  }
 
   printf(" total %.3f ms\n", process_link_timer.getMs());
   printf("\n");
+
+  auto& profiler = get_profiler();
+  profiler.add_counter("code_bytes", combined_stats.total_code_bytes);
+  profiler.add_counter("v2_code_bytes", combined_stats.total_v2_code_bytes);
+  profiler.add_counter("v2_link_bytes", combined_stats.total_v2_link_bytes);
+  profiler.add_counter("v2_pointers", combined_stats.total_v2_pointers);
+  profiler.add_counter("v2_pointer_seeks", combined_stats.total_v2_pointer_seeks);
+  profiler.add_counter("v2_symbols", combined_stats.total_v2_symbol_count);
+  profiler.add_counter("v2_symbol_links", combined_stats.total_v2_symbol_links);
+  profiler.add_counter("v3_code_bytes", combined_stats.v3_code_bytes);
+  profiler.add_counter("v3_link_bytes", combined_stats.v3_link_bytes);
+  profiler.add_counter("v3_pointers", combined_stats.v3_pointers);
+  profiler.add_counter("v3_split_pointers", combined_stats.v3_split_pointers);
+  profiler.add_counter("v3_word_pointers", combined_stats.v3_word_pointers);
+  profiler.add_counter("v3_pointer_seeks", combined_stats.v3_pointer_seeks);
+  profiler.add_counter("v3_symbols", combined_stats.v3_symbol_count);
+  profiler.add_counter("v3_symbol_link_offset", combined_stats.v3_symbol_link_offset);
+  profiler.add_counter("v3_symbol_link_word", combined_stats.v3_symbol_link_word);
+  if (cache) {
+    profiler.add_counter("cache_hits", cache->stats.hits.load());
+    profiler.add_counter("cache_misses", cache->stats.misses.load());
+    profiler.add_counter("cache_loaded_bytes", cache->stats.loaded_bytes.load());
+  }
 }
 
 /*!
  * Process all of the labels generated from linking and give them reasonable names.
  */
 void ObjectFileDB::process_labels() {
+  ScopedStage profile_stage("process_labels");
   printf("- Processing Labels...\n");
   Timer process_label_timer;
+  for_each_obj_parallel([&](ObjectFileData& obj) {
+    obj.linked_data.finish_labels();
+    obj.linked_data.set_ordered_label_names();
+  });
+
   uint32_t total = 0;
-  for_each_obj([&](ObjectFileData& obj) { total += obj.linked_data.set_ordered_label_names(); });
+  for_each_obj([&](ObjectFileData& obj) { total += obj.linked_data.labels.size(); });
 
   printf("Processed Labels:\n");
   printf(" total %d labels\n", total);
   printf(" total %.3f ms\n", process_label_timer.getMs());
   printf("\n");
+  get_profiler().add_counter("labels", total);
 }
 
 /*!
  * Dump object files and their linking data to text files for debugging
  */
 void ObjectFileDB::write_object_file_words(const std::string& output_dir, bool dump_v3_only) {
+  ScopedStage profile_stage("write_object_file_words");
   if (dump_v3_only) {
     printf("- Writing object file dumps (v3 only)...\n");
   } else {
@@ -273,24 +722,43 @@ void ObjectFileDB::write_object_file_words(const std::string& output_dir, bool d
   }
 
   Timer timer;
-  uint32_t total_bytes = 0, total_files = 0;
+  std::atomic<uint32_t> total_bytes = {0}, total_files = {0}, unchanged_files = {0};
 
-  for_each_obj([&](ObjectFileData& obj) {
+  for_each_obj_parallel([&](ObjectFileData& obj) {
+    if (obj.unchanged) {
+      return;
+    }
     if (obj.linked_data.segments == 3 || !dump_v3_only) {
-      auto file_text = obj.linked_data.print_words();
       auto file_name = combine_path(output_dir, obj.record.to_unique_name() + ".txt");
-      total_bytes += file_text.size();
-      write_text_file(file_name, file_text);
+      Timer obj_timer;
+      BufferedFileWriter out(file_name, output_mode());
+      obj.linked_data.print_words(out);
+      out.write('\n');
+      total_bytes += out.bytes_written();
+      out.close();
+      obj.cost(CostStage::PRINT).ns += obj_timer.getNs();
+      obj.cost(CostStage::PRINT).bytes += out.bytes_written();
       total_files++;
+      if (!out.file_changed()) {
+        unchanged_files++;
+      }
     }
   });
 
   printf("Wrote object file dumps:\n");
-  printf(" total %d files\n", total_files);
+  printf(" total %d files\n", total_files.load());
+  if (incremental) {
+    printf(" %d files had the same content and weren't modified\n", unchanged_files.load());
+  }
   printf(" total %.3f MB\n", total_bytes / ((float)(1u << 20u)));
   printf(" total %.3f ms (%.3f MB/sec)\n", timer.getMs(),
          total_bytes / ((1u << 20u) * timer.getSeconds()));
   printf("\n");
+
+  auto& profiler = get_profiler();
+  profiler.add_counter("files", total_files.load());
+  profiler.add_counter("bytes", total_bytes.load());
+  profiler.add_counter("unchanged_files", unchanged_files.load());
 }
 
 /*!
@@ -298,126 +766,537 @@ void ObjectFileDB::write_object_file_words(const std::string& output_dir, bool d
  */
 void ObjectFileDB::write_disassembly(const std::string& output_dir,
                                      bool disassemble_objects_without_functions) {
+  ScopedStage profile_stage("write_disassembly");
   printf("- Writing functions...\n");
   Timer timer;
-  uint32_t total_bytes = 0, total_files = 0;
+  std::atomic<uint32_t> total_bytes = {0}, total_files = {0}, unchanged_files = {0};
 
-  for_each_obj([&](ObjectFileData& obj) {
+  for_each_obj_parallel([&](ObjectFileData& obj) {
+    if (obj.unchanged) {
+      return;
+    }
     if (obj.linked_data.has_any_functions() || disassemble_objects_without_functions) {
-      auto file_text = obj.linked_data.print_disassembly();
       auto file_name = combine_path(output_dir, obj.record.to_unique_name() + ".func");
-      total_bytes += file_text.size();
-      write_text_file(file_name, file_text);
+      Timer obj_timer;
+      BufferedFileWriter out(file_name, output_mode());
+      obj.linked_data.print_disassembly(out);
+      out.write('\n');
+      total_bytes += out.bytes_written();
+      out.close();
+      obj.cost(CostStage::PRINT).ns += obj_timer.getNs();
+      obj.cost(CostStage::PRINT).bytes += out.bytes_written();
       total_files++;
+      if (!out.file_changed()) {
+        unchanged_files++;
+      }
+    }
+
+    if (get_config().release_instructions_after_printing) {
+      obj.linked_data.release_instructions();
     }
   });
 
   printf("Wrote functions dumps:\n");
-  printf(" total %d files\n", total_files);
+  printf(" total %d files\n", total_files.load());
+  if (incremental) {
+    printf(" %d files had the same content and weren't modified\n", unchanged_files.load());
+  }
   printf(" total %.3f MB\n", total_bytes / ((float)(1u << 20u)));
   printf(" total %.3f ms (%.3f MB/sec)\n", timer.getMs(),
          total_bytes / ((1u << 20u) * timer.getSeconds()));
   printf("\n");
+
+  auto& profiler = get_profiler();
+  profiler.add_counter("files", total_files.load());
+  profiler.add_counter("bytes", total_bytes.load());
+  profiler.add_counter("unchanged_files", unchanged_files.load());
 }
 
 /*!
- * Find code/data zones, identify functions, and disassemble
+ * Find code/data zones and identify functions. Functions aren't disassembled until something needs
+ * their instructions.
  */
 void ObjectFileDB::find_code() {
+  ScopedStage profile_stage("find_code");
   printf("- Finding code in object files...\n");
   LinkedObjectFile::Stats combined_stats;
   Timer timer;
+  std::atomic<int64_t> boundary_scan_ns = {0};
 
-  for_each_obj([&](ObjectFileData& obj) {
-    //      printf("fc %s\n", obj.record.to_unique_name().c_str());
+  for_each_obj_parallel([&](ObjectFileData& obj) {
+    if (obj.from_cache) {
+      return;
+    }
+    Timer obj_timer;
     obj.linked_data.find_code();
+    boundary_scan_ns += obj_timer.getNs();
     obj.linked_data.find_functions();
-    obj.linked_data.disassemble_functions();
+    obj.cost(CostStage::FIND_CODE) = {obj_timer.getNs(), obj.data.size()};
+  });
 
-    if (get_config().game_version == 1 || obj.record.to_unique_name() != "effect-control-v0") {
-      obj.linked_data.process_fp_relative_links();
-    } else {
-      printf("skipping process_fp_relative_links in %s\n", obj.record.to_unique_name().c_str());
+  // combine in order, after all objects are done.
+  for_each_obj([&](ObjectFileData& obj) { combined_stats.add(obj.linked_data.stats); });
+
+  printf("Found code:\n");
+  printf(" code %.3f MB\n", combined_stats.code_bytes / (float)(1 << 20));
+  printf(" data %.3f MB\n", combined_stats.data_bytes / (float)(1 << 20));
+  printf(" functions: %d\n", combined_stats.function_count);
+  printf(" code/data boundary scan %.3f ms (summed over threads)\n", boundary_scan_ns / 1.e6);
+  printf(" total %.3f ms\n", timer.getMs());
+  printf("\n");
+
+  auto& profiler = get_profiler();
+  profiler.add_counter("boundary_scan_ns", boundary_scan_ns.load());
+  profiler.add_counter("code_bytes", combined_stats.code_bytes);
+  profiler.add_counter("data_bytes", combined_stats.data_bytes);
+  profiler.add_counter("functions", combined_stats.function_count);
+}
+
+/*!
+ * Disassemble all functions and add labels for fp-relative data access. This is needed before
+ * process_labels if labels will be printed, as the scripts and dumps depend on these labels.
+ * With the cache enabled, this must always run, since this is where new objects are saved.
+ * If keep_instructions is false, the instructions are freed afterward, and anything that needs them
+ * later decodes them again.
+ */
+void ObjectFileDB::process_fp_relative_links(bool keep_instructions) {
+  ScopedStage profile_stage("process_fp_relative_links");
+  printf("- Disassembling and processing fp-relative links...\n");
+  LinkedObjectFile::Stats combined_stats;
+  Timer timer;
+
+  // all_scripts.lisp has the scripts from every object, so it needs unchanged objects too.
+  bool need_all_scripts = get_config().write_scripts && !get_config().write_scripts_per_object;
+  std::atomic<uint32_t> skipped = {0};
+  // messages are printed after the loop, in object order, so the log is the same on every run.
+  auto objs = get_objs_in_order();
+  std::vector<std::string> messages(objs.size());
+  parallel_for_objs(objs, [&](size_t idx, int) {
+    auto& obj = *objs[idx];
+    if (obj.unchanged && !need_all_scripts && !obj.link_type_info) {
+      // nothing will be printed for this object, and it doesn't need to be saved to the cache.
+      skipped++;
+      return;
+    }
+
+    if (!obj.from_cache) {
+      Timer obj_timer;
+      if (get_config().game_version == 1 || obj.record.to_unique_name() != "effect-control-v0") {
+        obj.linked_data.process_fp_relative_links();
+      } else {
+        messages[idx] +=
+            "skipping process_fp_relative_links in " + obj.record.to_unique_name() + "\n";
+        obj.linked_data.disassemble_functions();
+      }
+      obj.cost(CostStage::FP_LINKS) = {obj_timer.getNs(), obj.linked_data.stats.code_bytes};
+
+      if (cache) {
+        cache->save(obj.content_key, obj.linked_data, *obj.link_type_info);
+        obj.link_type_info.reset();
+      }
+    }
+
+    if (!keep_instructions) {
+      obj.linked_data.release_instructions();
     }
 
     auto& obj_stats = obj.linked_data.stats;
     if (obj_stats.code_bytes / 4 > obj_stats.decoded_ops) {
-      printf("Failed to decode all in %s (%d / %d)\n", obj.record.to_unique_name().c_str(),
-             obj_stats.decoded_ops, obj_stats.code_bytes / 4);
+      messages[idx] += "Failed to decode all in " + obj.record.to_unique_name() + " (" +
+                       std::to_string(obj_stats.decoded_ops) + " / " +
+                       std::to_string(obj_stats.code_bytes / 4) + ")\n";
     }
-    combined_stats.add(obj.linked_data.stats);
   });
 
-  printf("Found code:\n");
-  printf(" code %.3f MB\n", combined_stats.code_bytes / (float)(1 << 20));
-  printf(" data %.3f MB\n", combined_stats.data_bytes / (float)(1 << 20));
-  printf(" functions: %d\n", combined_stats.function_count);
+  for (auto& message : messages) {
+    printf("%s", message.c_str());
+  }
+  for_each_obj([&](ObjectFileData& obj) { combined_stats.add(obj.linked_data.stats); });
+
+  printf("Processed fp-relative links:\n");
   printf(" fp uses resolved: %d / %d (%.3f %%)\n", combined_stats.n_fp_reg_use_resolved,
          combined_stats.n_fp_reg_use,
          100.f * (float)combined_stats.n_fp_reg_use_resolved / combined_stats.n_fp_reg_use);
   auto total_ops = combined_stats.code_bytes / 4;
   printf(" decoded %d / %d (%.3f %%)\n", combined_stats.decoded_ops, total_ops,
          100.f * (float)combined_stats.decoded_ops / total_ops);
+  if (skipped) {
+    printf(" skipped %d unchanged objects\n", skipped.load());
+  }
+  if (cache) {
+    printf(" cache: saved %d objects, %.3f MB\n", cache->stats.saved.load(),
+           cache->stats.saved_bytes / (double)(1u << 20u));
+  }
   printf(" total %.3f ms\n", timer.getMs());
   printf("\n");
+
+  auto& profiler = get_profiler();
+  profiler.add_counter("fp_uses", combined_stats.n_fp_reg_use);
+  profiler.add_counter("fp_uses_resolved", combined_stats.n_fp_reg_use_resolved);
+  profiler.add_counter("ops", total_ops);
+  profiler.add_counter("decoded_ops", combined_stats.decoded_ops);
+  profiler.add_counter("skipped_objs", skipped.load());
+  if (cache) {
+    profiler.add_counter("cache_saved", cache->stats.saved.load());
+    profiler.add_counter("cache_saved_bytes", cache->stats.saved_bytes.load());
+  }
 }
 
 /*!
- * Finds and writes all scripts into a file named all_scripts.lisp.
+ * Finds and writes all scripts. Objects are printed in parallel. By default, the scripts are then
+ * written in order into a file named all_scripts.lisp. If write_scripts_per_object is set, each
+ * object with scripts gets its own .lisp file instead, written as soon as it is printed.
  * Doesn't change any state in ObjectFileDB.
  */
 void ObjectFileDB::find_and_write_scripts(const std::string& output_dir) {
+  ScopedStage profile_stage("find_and_write_scripts");
   printf("- Finding scripts in object files...\n");
   Timer timer;
-  std::string all_scripts;
+  bool per_object = get_config().write_scripts_per_object;
+  auto objs = get_objs_in_order();
 
-  for_each_obj([&](ObjectFileData& obj) {
+  // for all_scripts.lisp, the text for each object, in the same order as objs.
+  std::vector<std::string> fragments(per_object ? 0 : objs.size());
+  std::atomic<uint64_t> total_bytes = {0};
+  std::atomic<uint32_t> total_files = {0}, unchanged_files = {0}, skipped = {0};
+
+  parallel_for_objs(objs, [&](size_t idx, int) {
+    auto& obj = *objs[idx];
+    if (per_object && obj.unchanged) {
+      skipped++;
+      return;
+    }
+
+    Timer obj_timer;
+    std::string text;
     auto scripts = obj.linked_data.print_scripts();
+    obj.has_scripts = !scripts.empty();
     if (!scripts.empty()) {
-      all_scripts += ";--------------------------------------\n";
-      all_scripts += "; " + obj.record.to_unique_name() + "\n";
-      all_scripts += ";---------------------------------------\n";
-      all_scripts += scripts;
+      text += ";--------------------------------------\n";
+      text += "; " + obj.record.to_unique_name() + "\n";
+      text += ";---------------------------------------\n";
+      text += scripts;
+    }
+
+    if (per_object) {
+      if (!text.empty()) {
+        auto file_name = combine_path(output_dir, obj.record.to_unique_name() + ".lisp");
+        BufferedFileWriter out(file_name, output_mode());
+        out.write(text);
+        out.write('\n');
+        out.close();
+        total_files++;
+        if (!out.file_changed()) {
+          unchanged_files++;
+        }
+      }
+    }
+
+    obj.cost(CostStage::PRINT).ns += obj_timer.getNs();
+    obj.cost(CostStage::PRINT).bytes += text.size();
+    total_bytes += text.size();
+    if (!per_object) {
+      fragments[idx] = std::move(text);
     }
   });
 
-  auto file_name = combine_path(output_dir, "all_scripts.lisp");
-  write_text_file(file_name, all_scripts);
+  if (!per_object) {
+    BufferedFileWriter out(combine_path(output_dir, "all_scripts.lisp"), output_mode());
+    for (auto& fragment : fragments) {
+      out.write(fragment);
+      std::string().swap(fragment);
+    }
+    out.write('\n');
+    out.close();
+    total_files++;
+    if (!out.file_changed()) {
+      unchanged_files++;
+    }
+  }
 
   printf("Found scripts:\n");
+  printf(" total %d files\n", total_files.load());
+  if (incremental) {
+    printf(" %d files had the same content and weren't modified\n", unchanged_files.load());
+  }
+  if (skipped) {
+    printf(" skipped %d unchanged objects\n", skipped.load());
+  }
+  printf(" total %.3f MB\n", total_bytes / ((float)(1u << 20u)));
   printf(" total %.3f ms\n", timer.getMs());
   printf("\n");
+
+  auto& profiler = get_profiler();
+  profiler.add_counter("files", total_files.load());
+  profiler.add_counter("bytes", total_bytes.load());
+  profiler.add_counter("unchanged_files", unchanged_files.load());
+  profiler.add_counter("skipped_objs", skipped.load());
+}
+
+/*!
+ * Time the streaming pretty printer against the reference one on all scripts, and on the largest
+ * scripts by themselves, and check that they print the same thing.
+ */
+void ObjectFileDB::benchmark_script_printing(int max_scripts) {
+  printf("- Benchmarking script printing...\n");
+
+  struct Script {
+    Form* form = nullptr;
+    std::string obj_name;
+    size_t tokens = 0;
+  };
+
+  std::vector<std::unique_ptr<Arena>> arenas;
+  std::vector<Script> scripts;
+  size_t total_tokens = 0;
+  for_each_obj([&](ObjectFileData& obj) {
+    arenas.push_back(std::make_unique<Arena>());
+    for (auto* form : obj.linked_data.find_scripts(*arenas.back())) {
+      std::vector<FormToken> tokens;
+      form->toTokenList(tokens);
+      scripts.push_back({form, obj.record.to_unique_name(), tokens.size()});
+      total_tokens += tokens.size();
+    }
+  });
+
+  // all scripts, once each.
+  int mismatches = 0;
+  size_t total_bytes = 0;
+  double reference_ms = 0, streaming_ms = 0;
+  for (auto& script : scripts) {
+    Timer timer;
+    auto reference = script.form->toStringPrettyReference(0, 100);
+    reference_ms += timer.getMs();
+    timer.start();
+    auto streaming = script.form->toStringPretty(0, 100);
+    streaming_ms += timer.getMs();
+    total_bytes += streaming.size();
+    if (reference != streaming) {
+      printf("pretty printers differ on a script in %s\n", script.obj_name.c_str());
+      mismatches++;
+    }
+  }
+
+  printf("Benchmarked script printing:\n");
+  printf(" %d scripts, %d tokens, %.3f MB printed\n", int(scripts.size()), int(total_tokens),
+         total_bytes / (double)(1u << 20u));
+  printf(" reference %.3f ms, streaming %.3f ms (%.1fx)\n", reference_ms, streaming_ms,
+         reference_ms / streaming_ms);
+  printf(" %d scripts printed differently\n", mismatches);
+
+  // the largest scripts, best of a few runs each.
+  std::stable_sort(scripts.begin(), scripts.end(),
+                   [](const Script& a, const Script& b) { return a.tokens > b.tokens; });
+  if (int(scripts.size()) > max_scripts) {
+    scripts.resize(max_scripts);
+  }
+
+  constexpr int RUNS = 5;
+  printf(" %-28s %8s %7s %14s %14s %8s\n", "largest scripts", "tokens", "lines", "reference ms",
+         "streaming ms", "speedup");
+  for (auto& script : scripts) {
+    double best_reference = -1, best_streaming = -1;
+    int lines = 0;
+    for (int run = 0; run < RUNS; run++) {
+      Timer timer;
+      auto reference = script.form->toStringPrettyReference(0, 100);
+      double ms = timer.getMs();
+      if (best_reference < 0 || ms < best_reference) {
+        best_reference = ms;
+      }
+
+      timer.start();
+      auto streaming = script.form->toStringPretty(0, 100);
+      ms = timer.getMs();
+      if (best_streaming < 0 || ms < best_streaming) {
+        best_streaming = ms;
+      }
+      lines = 1 + std::count(streaming.begin(), streaming.end(), '\n');
+    }
+    printf(" %-28s %8d %7d %14.3f %14.3f %7.1fx\n", script.obj_name.c_str(), int(script.tokens),
+           lines, best_reference, best_streaming, best_reference / best_streaming);
+  }
+  printf("\n");
+}
+
+/*!
+ * Print every instruction with the reference to_string path and with append_to into a reused
+ * string like print_disassembly does, and compare the number of allocations and the time of each.
+ */
+void ObjectFileDB::benchmark_instruction_printing() {
+  printf("- Benchmarking instruction printing...\n");
+
+  int mismatches = 0;
+  size_t total_instructions = 0, total_functions = 0, total_bytes = 0;
+  uint64_t reference_allocs = 0, append_allocs = 0;
+  double reference_ms = 0, append_ms = 0;
+  std::string reference_text, append_text;
+  for_each_obj([&](ObjectFileData& obj) {
+    auto& file = obj.linked_data;
+    for (int seg = 0; seg < file.segments; seg++) {
+      for (auto& func : file.functions_by_seg.at(seg)) {
+        file.disassemble_function(seg, func);
+        total_functions++;
+        // the first word is the type tag of the function, which isn't printed.
+        size_t count = func.instructions.size();
+        if (count < 2) {
+          continue;
+        }
+        total_instructions += count - 1;
+
+        // the original printer made a new string for each instruction.
+        {
+          AllocationCounter allocs;
+          Timer timer;
+          size_t bytes = 0;
+          for (size_t i = 1; i < count; i++) {
+            auto str = func.instructions[i].to_string_reference(file);
+            bytes += str.size();
+          }
+          reference_ms += timer.getMs();
+          reference_allocs += allocs.count();
+          total_bytes += bytes;
+        }
+
+        // print_disassembly uses one string per function.
+        {
+          AllocationCounter allocs;
+          Timer timer;
+          std::string instr_str;
+          instr_str.reserve(128);
+          for (size_t i = 1; i < count; i++) {
+            instr_str.clear();
+            func.instructions[i].append_to(instr_str, file);
+          }
+          append_ms += timer.getMs();
+          append_allocs += allocs.count();
+        }
+
+        // check they print the same thing, outside of the timed loops.
+        for (size_t i = 1; i < count; i++) {
+          reference_text = func.instructions[i].to_string_reference(file);
+          append_text.clear();
+          func.instructions[i].append_to(append_text, file);
+          if (reference_text != append_text) {
+            if (mismatches < 8) {
+              printf("instruction printers differ in %s: \"%s\" vs \"%s\"\n",
+                     obj.record.to_unique_name().c_str(), reference_text.c_str(),
+                     append_text.c_str());
+            }
+            mismatches++;
+          }
+        }
+      }
+    }
+  });
+
+  double instrs = total_instructions ? double(total_instructions) : 1.;
+  printf("Benchmarked instruction printing:\n");
+  printf(" %d instructions in %d functions, %.3f MB printed\n", int(total_instructions),
+         int(total_functions), total_bytes / (double)(1u << 20u));
+  printf(" %-10s %14s %12s %10s\n", "path", "allocations", "per instr", "ms");
+  printf(" %-10s %14llu %12.3f %10.3f\n", "reference", (unsigned long long)reference_allocs,
+         reference_allocs / instrs, reference_ms);
+  printf(" %-10s %14llu %12.3f %10.3f\n", "append_to", (unsigned long long)append_allocs,
+         append_allocs / instrs, append_ms);
+  printf(" %d instructions printed differently\n", mismatches);
+  printf("\n");
 }
 
 void ObjectFileDB::analyze_functions() {
+  ScopedStage profile_stage("analyze_functions");
   printf("- Analyzing Functions...\n");
   Timer timer;
 
   if (get_config().find_basic_blocks) {
+    ScopedStage blocks_stage("find_basic_blocks");
     timer.start();
-    int total_basic_blocks = 0;
-    for_each_function([&](Function& func, int segment_id, ObjectFileData& data) {
+    std::atomic<int> total_basic_blocks = {0};
+    for_each_function_parallel([&](Function& func, int segment_id, ObjectFileData& data) {
+      if (data.unchanged && !(data.linked_data.segments == 3 && segment_id == 2)) {
+        // unchanged objects aren't written, but find_global_function_defs still needs the blocks
+        // of their top level function.
+        return;
+      }
+      // functions in an object are all done by the same thread, so this can add to its cost.
+      Timer func_timer;
+      data.linked_data.disassemble_function(segment_id, func);
       auto blocks = find_blocks_in_function(data.linked_data, segment_id, func);
       total_basic_blocks += blocks.size();
       func.basic_blocks = blocks;
       func.analyze_prologue(data.linked_data);
+      data.cost(CostStage::BASIC_BLOCKS).ns += func_timer.getNs();
+      data.cost(CostStage::BASIC_BLOCKS).bytes += 4 * (func.end_word - func.start_word);
     });
 
-    printf("Found %d basic blocks in %.3f ms\n", total_basic_blocks, timer.getMs());
+    printf("Found %d basic blocks in %.3f ms\n", total_basic_blocks.load(), timer.getMs());
+    get_profiler().add_counter("basic_blocks", total_basic_blocks.load());
   }
 
   {
+    ScopedStage defs_stage("find_global_function_defs");
     timer.start();
-    for_each_obj([&](ObjectFileData& data) {
-      if(data.linked_data.segments == 3) {
+    for_each_obj_parallel_with_type_info([&](ObjectFileData& data, TypeInfo& type_info) {
+      // this is done for unchanged objects too, so the type info is the same as in a full run.
+      if (data.linked_data.segments == 3) {
         // the top level segment should have a single function
         assert(data.linked_data.functions_by_seg.at(2).size() == 1);
 
         auto& func = data.linked_data.functions_by_seg.at(2).front();
         assert(func.guessed_name.empty());
         func.guessed_name = "(top-level-init)";
-        func.find_global_function_defs(data.linked_data);
+        func.find_global_function_defs(data.linked_data, type_info);
+      }
+
+      // unchanged objects won't be printed, so we're done with their instructions.
+      if (data.unchanged && get_config().release_instructions_after_printing) {
+        data.linked_data.release_instructions();
       }
     });
   }
 }
+
+/*!
+ * Make a table of the objects which took the most time in total, with the time for each stage.
+ * The bytes columns are the object's size, its code, and the size of everything printed for it.
+ */
+std::string ObjectFileDB::generate_cost_report(int max_objects) {
+  auto objs = get_objs_in_order();
+  int64_t total_ns = 0;
+  for (auto* obj : objs) {
+    total_ns += obj->total_cost_ns();
+  }
+
+  // stable, so ties stay in the dgo listing order
+  std::stable_sort(objs.begin(), objs.end(), [](ObjectFileData* a, ObjectFileData* b) {
+    return a->total_cost_ns() > b->total_cost_ns();
+  });
+  if (int(objs.size()) > max_objects) {
+    objs.resize(max_objects);
+  }
+
+  std::string result = "Slowest objects:\n";
+  char buff[512];
+  sprintf(buff, " %3s %-28s %8s %4s %5s %8s %9s %9s %6s %8s %8s %8s %8s %8s\n", "#", "object",
+          "size", "segs", "funcs", "code", "printed", "total ms", "%", "link", "find", "fp",
+          "blocks", "print");
+  result += buff;
+
+  int rank = 1;
+  for (auto* obj : objs) {
+    auto& ld = obj->linked_data;
+    int func_count = 0;
+    for (auto& seg_funcs : ld.functions_by_seg) {
+      func_count += seg_funcs.size();
+    }
+    auto ms = [&](CostStage stage) { return obj->cost(stage).ns / 1.e6; };
+    sprintf(buff, " %3d %-28s %8d %4d %5d %8d %9d %9.2f %5.1f%% %8.2f %8.2f %8.2f %8.2f %8.2f\n",
+            rank++, obj->record.to_unique_name().c_str(), int(obj->data.size()), ld.segments,
+            func_count, int(ld.stats.code_bytes), int(obj->cost(CostStage::PRINT).bytes),
+            obj->total_cost_ns() / 1.e6, total_ns ? 100. * obj->total_cost_ns() / total_ns : 0.,
+            ms(CostStage::LINK), ms(CostStage::FIND_CODE), ms(CostStage::FP_LINKS),
+            ms(CostStage::BASIC_BLOCKS), ms(CostStage::PRINT));
+    result += buff;
+  }
+  return result;
+}
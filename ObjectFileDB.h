@@ -9,10 +9,18 @@
 #define JAK2_DISASSEMBLER_OBJECTFILEDB_H
 
 #include <cassert>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include "LinkedObjectFile.h"
+#include "ObjectCache.h"
+#include "TypeSystem/TypeInfo.h"
+#include "util/BufferedFileWriter.h"
+#include "util/ByteSpan.h"
+#include "util/MappedFile.h"
+#include "util/Profiler.h"
+#include "util/ThreadPool.h"
 
 /*!
  * A "record" which can be used to identify an object file.
@@ -24,34 +32,81 @@ struct ObjectFileRecord {
   std::string to_unique_name() const;
 };
 
+/*!
+ * The stages which record the time and bytes they spent on each object, for finding objects which
+ * are slow to process.
+ */
+enum class CostStage { LINK, FIND_CODE, FP_LINKS, BASIC_BLOCKS, PRINT, COUNT };
+
+struct ObjectStageCost {
+  int64_t ns = 0;
+  uint64_t bytes = 0;  // input for link and find_code, code for fp links and blocks, output for print
+};
+
 /*!
  * All of the data for a single object file
  */
 struct ObjectFileData {
-  std::vector<uint8_t> data;     // raw bytes
+  ByteSpan data;                 // raw bytes, owned by the ObjectFileDB
   LinkedObjectFile linked_data;  // data including linking annotations
   ObjectFileRecord record;       // name
   uint32_t reference_count = 0;  // number of times its used.
+
+  // only used if the cache or incremental mode is enabled
+  ObjectCacheKey content_key;
+  bool from_cache = false;                   // linked_data was loaded, and is fully disassembled
+  std::unique_ptr<TypeInfo> link_type_info;  // found while linking, kept until it's saved
+  bool unchanged = false;  // incremental mode: same as last run, and its output files are current
+  bool has_scripts = false;  // scripts were found (or, if unchanged, were found last run)
+
+  ObjectStageCost costs[int(CostStage::COUNT)];
+  ObjectStageCost& cost(CostStage stage) { return costs[int(stage)]; }
+  int64_t total_cost_ns() const;
 };
 
 class ObjectFileDB {
  public:
-  ObjectFileDB(const std::vector<std::string>& _dgos);
+  ObjectFileDB(const std::vector<std::string>& _dgos, int jobs = 1);
+  void enable_cache(const std::string& cache_dir);
+  void enable_incremental(const std::string& output_dir);
   std::string generate_dgo_listing();
+  std::string generate_dgo_manifest();
   void process_link_data();
   void process_labels();
   void find_code();
+  void find_changed_objects(const std::string& output_dir);
+  void process_fp_relative_links(bool keep_instructions);
   void find_and_write_scripts(const std::string& output_dir);
+  void benchmark_script_printing(int max_scripts);
+  void benchmark_instruction_printing();
 
   void write_object_file_words(const std::string& output_dir, bool dump_v3_only);
   void write_disassembly(const std::string& output_dir, bool disassemble_objects_without_functions);
   void analyze_functions();
+  std::string generate_cost_report(int max_objects);
 
  private:
-  void get_objs_from_dgo(const std::string& filename);
-  void add_obj_from_dgo(const std::string& obj_name,
-                        uint8_t* obj_data,
-                        uint32_t obj_size,
+  /*!
+   * A DGO file which has been read, decompressed, and split into object files, but not yet added to
+   * the ObjectFileDB.
+   */
+  struct LoadedDgo {
+    struct Obj {
+      std::string name;
+      ByteSpan data;
+      uint32_t hash = 0;
+    };
+    std::string name;
+    std::unique_ptr<MappedFile> file;
+    std::unique_ptr<std::vector<uint8_t>> decompressed;  // null if the DGO wasn't compressed
+    std::vector<Obj> objs;
+  };
+
+  std::vector<LoadedDgo> load_dgos(const std::vector<std::string>& filenames, size_t& next_dgo);
+  void add_objs_from_dgo(LoadedDgo& dgo);
+  bool add_obj_from_dgo(const std::string& obj_name,
+                        ByteSpan obj_data,
+                        uint32_t hash,
                         const std::string& dgo_name);
 
   /*!
@@ -67,6 +122,64 @@ class ObjectFileDB {
     }
   }
 
+  /*!
+   * Apply f to all ObjectFileData's, using all threads in the pool.
+   * f must only modify the ObjectFileData it is given.  The order is not defined, so any results
+   * that need to be combined should be stored per object and combined afterward in order.
+   */
+  template <typename Func>
+  void for_each_obj_parallel(Func f) {
+    auto objs = get_objs_in_order();
+    parallel_for_objs(objs, [&](size_t idx, int) { f(*objs[idx]); });
+  }
+
+  /*!
+   * Apply f to all ObjectFileData's in parallel, giving each one its own TypeInfo to inform.
+   * Afterward, the TypeInfos are merged into the global TypeInfo in the right order. Method count
+   * conflicts are only checked when merging, so they are printed in the same order as a serial run.
+   */
+  template <typename Func>
+  void for_each_obj_parallel_with_type_info(Func f) {
+    auto objs = get_objs_in_order();
+    std::vector<TypeInfo> shards(objs.size());
+    for (auto& shard : shards) {
+      shard.defer_method_count_checks();
+    }
+    parallel_for_objs(objs, [&](size_t idx, int) { f(*objs[idx], shards[idx]); });
+    for (auto& shard : shards) {
+      get_type_info().merge(shard);
+    }
+  }
+
+  std::vector<ObjectFileData*> get_objs_in_order();
+
+  /*!
+   * Run f(idx, worker_id) for each of the objects, using all threads in the pool.
+   * If the profiler is enabled, the time spent on each object is added to the current stage.
+   */
+  template <typename Func>
+  void parallel_for_objs(const std::vector<ObjectFileData*>& objs, Func f) {
+    auto& profiler = get_profiler();
+    if (!profiler.enabled()) {
+      pool.parallel_for(objs.size(), f);
+      return;
+    }
+
+    std::vector<Profiler::ObjectEvent> events(objs.size());
+    pool.parallel_for(objs.size(), [&](size_t idx, int worker_id) {
+      auto start = profiler.now_ns();
+      f(idx, worker_id);
+      events[idx].start_ns = start;
+      events[idx].duration_ns = profiler.now_ns() - start;
+      events[idx].worker = worker_id;
+    });
+
+    for (size_t i = 0; i < objs.size(); i++) {
+      events[i].object = objs[i]->record.to_unique_name();
+      profiler.add_object_event(events[i]);
+    }
+  }
+
   /*!
    * Apply f to all functions
    * takes (Function, segment, linked_data)
@@ -88,8 +201,65 @@ class ObjectFileDB {
     });
   }
 
+  /*!
+   * Apply f to all functions, using all threads in the pool. Functions in the same object are
+   * always processed in order by the same thread.
+   */
+  template <typename Func>
+  void for_each_function_parallel(Func f) {
+    for_each_obj_parallel([&](ObjectFileData& data) {
+      for (int i = 0; i < int(data.linked_data.segments); i++) {
+        for (auto& goal_func : data.linked_data.functions_by_seg.at(i)) {
+          f(goal_func, i, data);
+        }
+      }
+    });
+  }
+
+  ThreadPool pool;
+  std::unique_ptr<ObjectCache> cache;  // null if the cache isn't enabled
+
+  // incremental mode: the objects (by unique name) from the manifest of the last run.
+  bool incremental = false;
+  bool have_previous_manifest = false;
+  uint64_t previous_settings_hash = 0;
+  struct PreviousObj {
+    ObjectCacheKey key;
+    bool had_scripts = false;
+  };
+  std::unordered_map<std::string, PreviousObj> previous_objs;
+
+  BufferedFileWriter::Mode output_mode() const {
+    return incremental ? BufferedFileWriter::Mode::KEEP_IF_UNCHANGED
+                       : BufferedFileWriter::Mode::OVERWRITE;
+  }
+
+  // Storage for the raw bytes of object files. ObjectFileData::data points into these.
+  std::vector<std::unique_ptr<MappedFile>> dgo_mappings;
+  std::vector<std::unique_ptr<std::vector<uint8_t>>> dgo_buffers;
+
+  /*!
+   * Identifies the contents of an object file, for finding duplicates.
+   */
+  struct ObjContentKey {
+    std::string name;
+    uint32_t size = 0;
+    uint32_t hash = 0;
+    bool operator==(const ObjContentKey& other) const {
+      return size == other.size && hash == other.hash && name == other.name;
+    }
+  };
+
+  struct ObjContentKeyHash {
+    size_t operator()(const ObjContentKey& key) const {
+      return std::hash<std::string>()(key.name) ^ (size_t(key.hash) * 31 + key.size);
+    }
+  };
+
   // Danger: after adding all object files, we assume that the vector never reallocates.
   std::unordered_map<std::string, std::vector<ObjectFileData>> obj_files_by_name;
+  // versions of objects with the given name, size and crc. Almost always just one.
+  std::unordered_map<ObjContentKey, std::vector<int>, ObjContentKeyHash> obj_versions_by_content;
   std::unordered_map<std::string, std::vector<ObjectFileRecord>> obj_files_by_dgo;
 
   std::vector<std::string> obj_file_order;
@@ -99,6 +269,13 @@ class ObjectFileDB {
     uint32_t total_obj_files = 0;
     uint32_t unique_obj_files = 0;
     uint32_t unique_obj_bytes = 0;
+    uint64_t mapped_bytes = 0;          // object data used directly from a mapped DGO file
+    uint64_t owned_bytes = 0;           // object data stored in buffers we allocated
+    uint64_t copies_avoided_bytes = 0;  // allocations a read + copy loader would have made
+    uint64_t decompressed_bytes = 0;
+    double decompress_seconds = 0;
+    uint64_t hashed_bytes = 0;
+    double hash_seconds = 0;
   } stats;
 };
 
@@ -0,0 +1,179 @@
+/*!
+ * @file SegmentWords.cpp
+ * Storage for the words of a segment, with the link info kept separately.
+ */
+
+#include "SegmentWords.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+#include "util/BinaryReader.h"
+#include "util/BinaryWriter.h"
+
+/*!
+ * Set the words of the segment to a copy of the given data. Can only be done once, before linking.
+ */
+void SegmentWords::assign(const uint8_t* data, size_t word_count) {
+  assert(m_data.empty() && m_links.empty() && m_linking);
+  m_data.resize(word_count);
+  if (word_count) {
+    memcpy(m_data.data(), data, word_count * 4);
+  }
+}
+
+/*!
+ * Add a link while linking. Links can come in any order, and are sorted in finish_linking.
+ */
+void SegmentWords::add_link(size_t idx, LinkedWord word) {
+  assert(m_linking);
+  if (m_linked.empty()) {
+    m_linked.resize(m_data.size(), false);
+  }
+  m_linked.at(idx) = true;
+  m_links.push_back({uint32_t(idx), word});
+}
+
+void SegmentWords::set_link_to_label(size_t idx, LinkedWord::Kind kind, int label_id) {
+  LinkedWord word(m_data.at(idx));
+  word.set_to_label(kind, label_id);
+  add_link(idx, word);
+}
+
+void SegmentWords::set_link_to_symbol(size_t idx, LinkedWord::Kind kind, int symbol_id) {
+  LinkedWord word(m_data.at(idx));
+  word.set_to_symbol(kind, symbol_id);
+  add_link(idx, word);
+}
+
+/*!
+ * Has a link been added to this word? Only available while linking.
+ */
+bool SegmentWords::is_linked(size_t idx) const {
+  assert(m_linking);
+  assert(idx < m_data.size());
+  return !m_linked.empty() && m_linked[idx];
+}
+
+/*!
+ * Sort the link table by word index. If a word was linked more than once, the last link wins.
+ * Also builds the type tag index.
+ */
+void SegmentWords::finish_linking() {
+  assert(m_linking);
+  // links are usually added in order, so this is often already sorted.
+  auto by_word = [](const Link& a, const Link& b) { return a.word_idx < b.word_idx; };
+  if (!std::is_sorted(m_links.begin(), m_links.end(), by_word)) {
+    std::stable_sort(m_links.begin(), m_links.end(), by_word);
+  }
+
+  // keep only the last link of each word.
+  size_t kept = 0;
+  for (size_t i = 0; i < m_links.size(); i++) {
+    if (i + 1 < m_links.size() && m_links[i + 1].word_idx == m_links[i].word_idx) {
+      continue;
+    }
+    m_links[kept++] = m_links[i];
+  }
+  m_links.erase(m_links.begin() + kept, m_links.end());
+  m_links.shrink_to_fit();
+
+  m_linked = std::vector<bool>();
+  m_linking = false;
+  index_type_tags();
+}
+
+/*!
+ * Copy the TYPE_PTR links, in order, into the type tag index.
+ */
+void SegmentWords::index_type_tags() {
+  assert(m_type_tags.empty());
+  for (auto& link : m_links) {
+    if (link.word.kind() == LinkedWord::TYPE_PTR) {
+      m_type_tags.push_back(link);
+    }
+  }
+  m_type_tags.shrink_to_fit();
+}
+
+/*!
+ * Get a word, including its link info.
+ */
+LinkedWord SegmentWords::at(size_t idx) const {
+  assert(!m_linking);
+  auto link = first_link_at_or_after(idx);
+  if (link < m_links.size() && m_links[link].word_idx == idx) {
+    return m_links[link].word;
+  }
+  return LinkedWord(m_data.at(idx));
+}
+
+/*!
+ * Get a word, including its link info, for loops that go through the words in order. link_cursor is
+ * an index in links() at or before the first link at or after idx, and is advanced to it. Start
+ * with first_link_at_or_after(first_idx). Doesn't search the link table.
+ */
+LinkedWord SegmentWords::at(size_t idx, size_t& link_cursor) const {
+  assert(!m_linking);
+  while (link_cursor < m_links.size() && m_links[link_cursor].word_idx < idx) {
+    link_cursor++;
+  }
+  if (link_cursor < m_links.size() && m_links[link_cursor].word_idx == idx) {
+    return m_links[link_cursor].word;
+  }
+  return LinkedWord(m_data.at(idx));
+}
+
+/*!
+ * Get the index in links() of the first linked word at or after the given word index.
+ * Returns links().size() if there is none.
+ */
+size_t SegmentWords::first_link_at_or_after(size_t idx) const {
+  auto it = std::lower_bound(m_links.begin(), m_links.end(), idx,
+                             [](const Link& link, size_t i) { return link.word_idx < i; });
+  return it - m_links.begin();
+}
+
+/*!
+ * All linked words, sorted by word index. Only available after linking is finished.
+ */
+const std::vector<SegmentWords::Link>& SegmentWords::links() const {
+  assert(!m_linking);
+  return m_links;
+}
+
+/*!
+ * All linked words which are type tags, sorted by word index. Only available after linking is
+ * finished.
+ */
+const std::vector<SegmentWords::Link>& SegmentWords::type_tags() const {
+  assert(!m_linking);
+  return m_type_tags;
+}
+
+static_assert(std::is_trivially_copyable<SegmentWords::Link>::value,
+              "links are written to the cache as raw bytes");
+
+/*!
+ * Write the words and link table to a cache entry. Linking must be finished.
+ */
+void SegmentWords::write_to(BinaryWriter& out) const {
+  assert(!m_linking);
+  out.add<uint32_t>(m_data.size());
+  out.add_bytes(m_data.data(), m_data.size() * sizeof(uint32_t));
+  out.add<uint32_t>(m_links.size());
+  out.add_bytes(m_links.data(), m_links.size() * sizeof(Link));
+}
+
+/*!
+ * Read words and links written by write_to. The result is the same as after finish_linking().
+ */
+void SegmentWords::read_from(BinaryReader& in) {
+  assert(m_data.empty() && m_links.empty() && m_linking);
+  m_data.resize(in.read<uint32_t>());
+  in.read_array(m_data.data(), m_data.size());
+  m_links.assign(in.read<uint32_t>(), Link{0, LinkedWord(0)});
+  in.read_array(m_links.data(), m_links.size());
+  m_linking = false;
+  index_type_tags();
+}
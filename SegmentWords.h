@@ -0,0 +1,65 @@
+/*!
+ * @file SegmentWords.h
+ * Storage for the words of a segment, with the link info kept separately.
+ */
+
+#ifndef JAK2_DISASSEMBLER_SEGMENTWORDS_H
+#define JAK2_DISASSEMBLER_SEGMENTWORDS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "LinkedWord.h"
+
+class BinaryReader;
+class BinaryWriter;
+
+/*!
+ * The words of a segment. The raw data is stored in one array, which can be scanned quickly, and
+ * the link info is stored in a separate table which only has entries for linked words.
+ *
+ * While linking, links are appended to the link table in the order they arrive, and a bit per word
+ * remembers which words are linked. finish_linking() then sorts the table by word index, and also
+ * makes an index of the type tags, which is used to find the code and functions without looking at
+ * every link.
+ */
+class SegmentWords {
+ public:
+  struct Link {
+    uint32_t word_idx;
+    LinkedWord word;
+  };
+
+  void assign(const uint8_t* data, size_t word_count);
+  void set_link_to_label(size_t idx, LinkedWord::Kind kind, int label_id);
+  void set_link_to_symbol(size_t idx, LinkedWord::Kind kind, int symbol_id);
+  bool is_linked(size_t idx) const;
+  void finish_linking();
+  void write_to(BinaryWriter& out) const;
+  void read_from(BinaryReader& in);
+
+  size_t size() const { return m_data.size(); }
+  bool empty() const { return m_data.empty(); }
+
+  // just the data, without checking for links.
+  uint32_t data(size_t idx) const { return m_data.at(idx); }
+  const std::vector<uint32_t>& all_data() const { return m_data; }
+
+  LinkedWord at(size_t idx) const;
+  LinkedWord at(size_t idx, size_t& link_cursor) const;
+  size_t first_link_at_or_after(size_t idx) const;
+  const std::vector<Link>& links() const;
+  const std::vector<Link>& type_tags() const;
+
+ private:
+  void add_link(size_t idx, LinkedWord word);
+  void index_type_tags();
+
+  std::vector<uint32_t> m_data;
+  std::vector<Link> m_links;      // sorted by word_idx, once linking is finished
+  std::vector<Link> m_type_tags;  // just the TYPE_PTR links, sorted by word_idx
+  std::vector<bool> m_linked;     // while linking, which words have a link
+  bool m_linking = true;          // until finish_linking or read_from
+};
+
+#endif  // JAK2_DISASSEMBLER_SEGMENTWORDS_H
@@ -17,6 +17,11 @@ class GoalSymbol {
     return m_has_type_info;
   }
 
+  const TypeSpec& get_type() const {
+    assert(m_has_type_info);
+    return m_type;
+  }
+
   void set_type(TypeSpec ts) {
     if(m_has_type_info) {
       if(ts != m_type) {
@@ -15,7 +15,11 @@ class GoalType {
     return m_method_count_set;
   }
 
-  void set_methods(int n);
+  int get_method_count() const {
+    return m_method_count;
+  }
+
+  bool set_methods(int n);
 
  private:
   std::string m_name;
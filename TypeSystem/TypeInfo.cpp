@@ -1,6 +1,10 @@
 #include "TypeInfo.h"
 
+#include <cassert>
+#include <cstdio>
 #include <utility>
+#include "util/BinaryReader.h"
+#include "util/BinaryWriter.h"
 
 namespace {
 TypeInfo gTypeInfo;
@@ -83,6 +87,119 @@ void TypeInfo::inform_type(const std::string& name) {
 void TypeInfo::inform_type_method_count(const std::string& name, int methods) {
   // create type and symbol
   inform_type(name);
-  m_types.at(name).set_methods(methods);
+  set_method_count(name, methods);
 }
 
+/*!
+ * Set the method count of a type that exists. If method count checks are deferred, the count is
+ * just recorded. Otherwise, a conflict with the type's existing count is printed.
+ */
+void TypeInfo::set_method_count(const std::string& name, int methods) {
+  auto& type = m_types.at(name);
+  if (m_defer_method_count_checks) {
+    m_method_counts.emplace_back(name, methods);
+    type.set_methods(methods);
+    return;
+  }
+
+  if (!type.set_methods(methods)) {
+    printf("Type %s had %d methods, set_methods tried to change it to %d\n", name.c_str(),
+           type.get_method_count(), methods);
+  }
+}
+
+/*!
+ * Record method counts in the order they are informed instead of checking them. This is used for
+ * the TypeInfos informed on worker threads: merging them replays the counts in order, so conflicts
+ * are printed from the merge, in object order, exactly as if everything was informed serially.
+ */
+void TypeInfo::defer_method_count_checks() {
+  assert(m_types.size() == 1 && m_method_counts.empty());
+  m_defer_method_count_checks = true;
+}
+
+/*!
+ * Add everything learned by another TypeInfo to this one.
+ * This is used to combine TypeInfos built separately for each object file. Merging them in the
+ * order the objects would have been processed gives the same result (and the same conflict checks)
+ * as informing a single TypeInfo about everything in order, as long as the other TypeInfo deferred
+ * its method count checks.
+ */
+void TypeInfo::merge(const TypeInfo& other) {
+  for (const auto& kv : other.m_symbols) {
+    if (kv.second.has_type_info()) {
+      inform_symbol(kv.first, kv.second.get_type());
+    } else {
+      inform_symbol_with_no_type_info(kv.first);
+    }
+  }
+
+  for (const auto& kv : other.m_types) {
+    if (m_types.find(kv.first) == m_types.end()) {
+      m_types[kv.first] = GoalType(kv.first);
+    }
+    if (!other.m_defer_method_count_checks && kv.second.has_method_count()) {
+      set_method_count(kv.first, kv.second.get_method_count());
+    }
+  }
+
+  for (const auto& count : other.m_method_counts) {
+    set_method_count(count.first, count.second);
+  }
+}
+
+/*!
+ * Write everything this TypeInfo knows to a cache entry. Method count checks must be deferred, and
+ * the method counts are written in the order they were informed.
+ */
+void TypeInfo::write_to(BinaryWriter& out) const {
+  assert(m_defer_method_count_checks);
+  out.add<uint32_t>(m_symbols.size());
+  for (const auto& kv : m_symbols) {
+    out.add_string(kv.first);
+    out.add<uint8_t>(kv.second.has_type_info());
+    if (kv.second.has_type_info()) {
+      kv.second.get_type().write_to(out);
+    }
+  }
+
+  out.add<uint32_t>(m_types.size());
+  for (const auto& kv : m_types) {
+    out.add_string(kv.first);
+  }
+
+  out.add<uint32_t>(m_method_counts.size());
+  for (const auto& count : m_method_counts) {
+    out.add_string(count.first);
+    out.add<int32_t>(count.second);
+  }
+}
+
+/*!
+ * Inform this TypeInfo of everything in a cache entry written by write_to.
+ */
+void TypeInfo::read_from(BinaryReader& in) {
+  auto n_symbols = in.read<uint32_t>();
+  for (uint32_t i = 0; i < n_symbols; i++) {
+    auto name = in.read_string();
+    if (in.read<uint8_t>()) {
+      inform_symbol(name, TypeSpec::read_from(in));
+    } else {
+      inform_symbol_with_no_type_info(name);
+    }
+  }
+
+  auto n_types = in.read<uint32_t>();
+  for (uint32_t i = 0; i < n_types; i++) {
+    auto name = in.read_string();
+    if (m_types.find(name) == m_types.end()) {
+      m_types[name] = GoalType(name);
+    }
+  }
+
+  auto n_method_counts = in.read<uint32_t>();
+  for (uint32_t i = 0; i < n_method_counts; i++) {
+    auto name = in.read_string();
+    set_method_count(name, in.read<int32_t>());
+  }
+}
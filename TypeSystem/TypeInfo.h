@@ -2,6 +2,8 @@
 #define JAK_DISASSEMBLER_TYPEINFO_H
 
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include "GoalType.h"
 #include "GoalFunction.h"
 #include "GoalSymbol.h"
@@ -14,13 +16,23 @@ class TypeInfo {
   void inform_symbol_with_no_type_info(const std::string& name);
   void inform_type(const std::string& name);
   void inform_type_method_count(const std::string& name, int methods);
+  void merge(const TypeInfo& other);
+  void defer_method_count_checks();
+  void write_to(BinaryWriter& out) const;
+  void read_from(BinaryReader& in);
 
   std::string get_summary();
 
  private:
+  void set_method_count(const std::string& name, int methods);
+
   std::unordered_map<std::string, GoalType> m_types;
   std::unordered_map<std::string, GoalFunction> m_global_functions;
   std::unordered_map<std::string, GoalSymbol> m_symbols;
+
+  // if method count checks are deferred, every method count informed, in order.
+  bool m_defer_method_count_checks = false;
+  std::vector<std::pair<std::string, int>> m_method_counts;
 };
 
 TypeInfo& get_type_info();
@@ -1,4 +1,6 @@
 #include "TypeSpec.h"
+#include "util/BinaryReader.h"
+#include "util/BinaryWriter.h"
 
 std::string TypeSpec::to_string() const {
   if (m_args.empty()) {
@@ -15,19 +17,36 @@ std::string TypeSpec::to_string() const {
   }
 }
 
-std::shared_ptr<Form> TypeSpec::to_form() const {
+Form* TypeSpec::to_form(Arena& arena) const {
   if (m_args.empty()) {
-    return toForm(m_base_type);
+    return toForm(arena, m_base_type);
   } else {
-    std::vector<std::shared_ptr<Form>> all;
-    all.push_back(toForm(m_base_type));
+    std::vector<Form*> all;
+    all.push_back(toForm(arena, m_base_type));
     for (const auto& x : m_args) {
-      all.push_back(x.to_form());
+      all.push_back(x.to_form(arena));
     }
-    return buildList(all);
+    return buildList(arena, all);
   }
 }
 
+void TypeSpec::write_to(BinaryWriter& out) const {
+  out.add_string(m_base_type);
+  out.add<uint32_t>(m_args.size());
+  for (const auto& x : m_args) {
+    x.write_to(out);
+  }
+}
+
+TypeSpec TypeSpec::read_from(BinaryReader& in) {
+  TypeSpec result(in.read_string());
+  auto n_args = in.read<uint32_t>();
+  for (uint32_t i = 0; i < n_args; i++) {
+    result.m_args.push_back(read_from(in));
+  }
+  return result;
+}
+
 bool TypeSpec::operator==(const TypeSpec& other) const {
   if (m_base_type != other.m_base_type) {
     return false;
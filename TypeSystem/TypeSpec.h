@@ -5,6 +5,9 @@
 #include <vector>
 #include "util/LispPrint.h"
 
+class BinaryReader;
+class BinaryWriter;
+
 class TypeSpec {
  public:
   TypeSpec() = default;
@@ -12,7 +15,10 @@ class TypeSpec {
   TypeSpec(std::string base_type, std::vector<TypeSpec> args) : m_base_type(std::move(base_type)), m_args(std::move(args)) { }
 
   std::string to_string() const;
-  std::shared_ptr<Form> to_form() const;
+  Form* to_form(Arena& arena) const;
+
+  void write_to(BinaryWriter& out) const;
+  static TypeSpec read_from(BinaryReader& in);
 
   bool operator==(const TypeSpec& other) const;
   bool operator!=(const TypeSpec& other) const;
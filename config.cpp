@@ -18,9 +18,12 @@ void set_config(const std::string& path_to_config_file) {
   gConfig.write_disassembly = cfg.at("write_disassembly").get<bool>();
   gConfig.write_hexdump = cfg.at("write_hexdump").get<bool>();
   gConfig.write_scripts = cfg.at("write_scripts").get<bool>();
+  gConfig.write_scripts_per_object = cfg.at("write_scripts_per_object").get<bool>();
   gConfig.write_hexdump_on_v3_only = cfg.at("write_hexdump_on_v3_only").get<bool>();
   gConfig.disassemble_objects_without_functions =
       cfg.at("disassemble_objects_without_functions").get<bool>();
   gConfig.find_basic_blocks = cfg.at("find_basic_blocks").get<bool>();
   gConfig.write_hex_near_instructions = cfg.at("write_hex_near_instructions").get<bool>();
+  gConfig.release_instructions_after_printing =
+      cfg.at("release_instructions_after_printing").get<bool>();
 }
\ No newline at end of file
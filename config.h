@@ -10,10 +10,12 @@ struct Config {
   bool write_disassembly = false;
   bool write_hexdump = false;
   bool write_scripts = false;
+  bool write_scripts_per_object = false;
   bool write_hexdump_on_v3_only = false;
   bool disassemble_objects_without_functions = false;
   bool find_basic_blocks = false;
   bool write_hex_near_instructions = false;
+  bool release_instructions_after_printing = false;
   // ...
 };
 
@@ -1,37 +1,159 @@
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
 #include <string>
 #include <vector>
 #include "ObjectFileDB.h"
 #include "config.h"
 #include "util/FileIO.h"
 #include "TypeSystem/TypeInfo.h"
+#include "util/Profiler.h"
+#include "util/ThreadPool.h"
+#include "Disasm/DecoderSweep.h"
+#include "util/SymbolTableBench.h"
+#include "util/CrcBench.h"
 
 int main(int argc, char** argv) {
   printf("Jak Disassembler\n");
   init_crc();
   init_opcode_info();
 
-  if (argc != 4) {
-    printf("usage: jak_disassembler <config_file> <in_folder> <out_folder>\n");
+  // optional flags come before the positional arguments
+  int jobs = ThreadPool::default_thread_count();
+  std::string cache_dir;
+  std::string profile_file, trace_file;
+  int slowest_count = 10;
+  int script_bench_count = 0;
+  bool incremental = false;
+  bool decoder_sweep = false;
+  bool symbol_table_bench = false;
+  bool crc_bench = false;
+  bool print_alloc_bench = false;
+  DecoderSweepSettings sweep_settings;
+  int arg_idx = 1;
+  while (arg_idx < argc && argv[arg_idx][0] == '-') {
+    std::string flag = argv[arg_idx];
+    if (flag == "--jobs" && arg_idx + 1 < argc) {
+      jobs = std::max(1, atoi(argv[arg_idx + 1]));
+      arg_idx += 2;
+    } else if (flag == "--cache" && arg_idx + 1 < argc) {
+      cache_dir = argv[arg_idx + 1];
+      arg_idx += 2;
+    } else if (flag == "--profile" && arg_idx + 1 < argc) {
+      profile_file = argv[arg_idx + 1];
+      arg_idx += 2;
+    } else if (flag == "--trace" && arg_idx + 1 < argc) {
+      trace_file = argv[arg_idx + 1];
+      arg_idx += 2;
+    } else if (flag == "--slowest" && arg_idx + 1 < argc) {
+      slowest_count = std::max(0, atoi(argv[arg_idx + 1]));
+      arg_idx += 2;
+    } else if (flag == "--script-print-bench" && arg_idx + 1 < argc) {
+      script_bench_count = std::max(1, atoi(argv[arg_idx + 1]));
+      arg_idx += 2;
+    } else if (flag == "--print-alloc-bench") {
+      print_alloc_bench = true;
+      arg_idx++;
+    } else if (flag == "--incremental") {
+      incremental = true;
+      arg_idx++;
+    } else if (flag == "--symbol-table-bench") {
+      symbol_table_bench = true;
+      arg_idx++;
+    } else if (flag == "--crc-bench") {
+      crc_bench = true;
+      arg_idx++;
+    } else if (flag == "--decoder-sweep") {
+      decoder_sweep = true;
+      arg_idx++;
+    } else if (flag == "--decoder-sweep-full") {
+      decoder_sweep = true;
+      sweep_settings.full = true;
+      arg_idx++;
+    } else {
+      printf("unknown option %s\n", flag.c_str());
+      return 1;
+    }
+  }
+
+  if (symbol_table_bench && arg_idx == argc) {
+    run_symbol_table_bench(jobs);
+    return 0;
+  }
+
+  if (crc_bench && arg_idx == argc) {
+    run_crc_bench();
+    return 0;
+  }
+
+  if (decoder_sweep && arg_idx == argc) {
+    ThreadPool pool(jobs);
+    run_decoder_sweep(sweep_settings, pool);
+    return 0;
+  }
+
+  if (argc - arg_idx != 3) {
+    printf(
+        "usage: jak_disassembler [--jobs N] [--cache DIR] [--incremental] [--profile FILE] "
+        "[--trace FILE] [--slowest N] [--script-print-bench N] [--print-alloc-bench] "
+        "<config_file> <in_folder> <out_folder>\n");
+    printf("       jak_disassembler [--jobs N] --decoder-sweep | --decoder-sweep-full\n");
+    printf("       jak_disassembler [--jobs N] --symbol-table-bench\n");
+    printf("       jak_disassembler --crc-bench\n");
     return 1;
   }
 
-  set_config(argv[1]);
-  std::string in_folder = argv[2];
-  std::string out_folder = argv[3];
+  set_config(argv[arg_idx]);
+  std::string in_folder = argv[arg_idx + 1];
+  std::string out_folder = argv[arg_idx + 2];
 
   std::vector<std::string> dgos;
   for (const auto& dgo_name : get_config().dgo_names) {
     dgos.push_back(combine_path(in_folder, dgo_name));
   }
 
-  ObjectFileDB db(dgos);
-  write_text_file(combine_path(out_folder, "dgo.txt"), db.generate_dgo_listing());
+  if (!profile_file.empty() || !trace_file.empty()) {
+    get_profiler().enable(jobs);
+  }
+
+  ObjectFileDB db(dgos, jobs);
+  if (!cache_dir.empty()) {
+    db.enable_cache(cache_dir);
+  }
+  if (incremental) {
+    db.enable_incremental(out_folder);
+    write_text_file_if_changed(combine_path(out_folder, "dgo.txt"), db.generate_dgo_listing());
+  } else {
+    write_text_file(combine_path(out_folder, "dgo.txt"), db.generate_dgo_listing());
+  }
 
   db.process_link_data();
   db.find_code();
+  if (incremental) {
+    db.find_changed_objects(out_folder);
+  }
+
+  // the printers need the labels found by disassembling, and the cache stores fully disassembled
+  // objects. Otherwise, functions are only disassembled when analysis needs them. Keeping the
+  // instructions just saves decoding them again for the later stages that use them.
+  const auto& config = get_config();
+  if (config.write_scripts || config.write_hexdump || config.write_disassembly ||
+      !cache_dir.empty() || script_bench_count || print_alloc_bench) {
+    db.process_fp_relative_links(config.write_disassembly || config.find_basic_blocks ||
+                                 print_alloc_bench);
+  }
   db.process_labels();
 
+  if (script_bench_count) {
+    db.benchmark_script_printing(script_bench_count);
+    return 0;
+  }
+
+  if (print_alloc_bench) {
+    db.benchmark_instruction_printing();
+    return 0;
+  }
+
   if (get_config().write_scripts) {
     db.find_and_write_scripts(out_folder);
   }
@@ -46,7 +168,24 @@ int main(int argc, char** argv) {
     db.write_disassembly(out_folder, get_config().disassemble_objects_without_functions);
   }
 
+  if (incremental) {
+    // written last, so an interrupted run doesn't leave a manifest for output that wasn't written.
+    write_text_file_if_changed(combine_path(out_folder, "dgo_manifest.txt"),
+                               db.generate_dgo_manifest());
+  }
+
   printf("%s\n", get_type_info().get_summary().c_str());
 
+  if (slowest_count > 0) {
+    printf("%s\n", db.generate_cost_report(slowest_count).c_str());
+  }
+
+  if (!profile_file.empty()) {
+    write_text_file(profile_file, get_profiler().to_json());
+  }
+  if (!trace_file.empty()) {
+    write_text_file(trace_file, get_profiler().to_chrome_trace());
+  }
+
   return 0;
 }
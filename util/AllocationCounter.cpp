@@ -0,0 +1,51 @@
+/*!
+ * @file AllocationCounter.cpp
+ * Replaces the global operator new so allocations can be counted. When no AllocationCounter is
+ * active, this only adds a check of a thread local flag.
+ */
+
+#include "AllocationCounter.h"
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local bool t_counting = false;
+thread_local uint64_t t_allocations = 0;
+}  // namespace
+
+void* operator new(size_t size) {
+  if (t_counting) {
+    t_allocations++;
+  }
+  void* result = malloc(size ? size : 1);
+  if (!result) {
+    throw std::bad_alloc();
+  }
+  return result;
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+AllocationCounter::AllocationCounter() {
+  assert(!t_counting);
+  t_allocations = 0;
+  t_counting = true;
+}
+
+AllocationCounter::~AllocationCounter() {
+  t_counting = false;
+}
+
+/*!
+ * Get the number of allocations made on this thread since the counter was created.
+ */
+uint64_t AllocationCounter::count() const {
+  return t_allocations;
+}
@@ -0,0 +1,24 @@
+/*!
+ * @file AllocationCounter.h
+ * Count the heap allocations made by a piece of code, for benchmarks.
+ */
+
+#ifndef JAK_DISASSEMBLER_ALLOCATIONCOUNTER_H
+#define JAK_DISASSEMBLER_ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+/*!
+ * Counts calls to operator new on this thread while it exists. Counters can't be nested.
+ */
+class AllocationCounter {
+ public:
+  AllocationCounter();
+  ~AllocationCounter();
+  AllocationCounter(const AllocationCounter&) = delete;
+  AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+  uint64_t count() const;
+};
+
+#endif  // JAK_DISASSEMBLER_ALLOCATIONCOUNTER_H
@@ -0,0 +1,62 @@
+#ifndef JAK_DISASSEMBLER_ARENA_H
+#define JAK_DISASSEMBLER_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*!
+ * Bump allocator for lots of small objects that all die at the same time.
+ * Objects are carved out of large blocks and never destroyed individually. Everything is freed at
+ * once when the arena is destroyed, so only trivially destructible types can be allocated, and
+ * pointers between them don't own anything.
+ * Not thread safe: use one arena per thread.
+ */
+class Arena {
+ public:
+  explicit Arena(size_t block_size = 1 << 16) : m_block_size(block_size) {}
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  template <typename T, typename... Args>
+  T* make(Args&&... args) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "objects in an arena are never destroyed");
+    return new (alloc(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  }
+
+  void* alloc(size_t size, size_t align) {
+    auto pad = (align - (m_next & (align - 1))) & (align - 1);
+    if (m_next + pad + size > m_end) {
+      new_block(size + align);
+      pad = (align - (m_next & (align - 1))) & (align - 1);
+    }
+    auto* result = (void*)(m_next + pad);
+    m_next += pad + size;
+    m_bytes_used += size;
+    return result;
+  }
+
+  // total size of everything allocated, not including padding or unused space in blocks.
+  size_t bytes_used() const { return m_bytes_used; }
+
+ private:
+  void new_block(size_t min_size) {
+    auto size = min_size > m_block_size ? min_size : m_block_size;
+    m_blocks.emplace_back(new uint8_t[size]);
+    m_next = uintptr_t(m_blocks.back().get());
+    m_end = m_next + size;
+  }
+
+  size_t m_block_size;
+  std::vector<std::unique_ptr<uint8_t[]>> m_blocks;
+  uintptr_t m_next = 0;
+  uintptr_t m_end = 0;
+  size_t m_bytes_used = 0;
+};
+
+#endif  // JAK_DISASSEMBLER_ARENA_H
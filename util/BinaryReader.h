@@ -3,24 +3,45 @@
 
 #include <cstdint>
 #include <cassert>
+#include <cstring>
+#include <string>
 #include <vector>
 
 class BinaryReader {
 public:
-  BinaryReader(uint8_t* _buffer, uint32_t _size) : buffer(_buffer), size(_size) {
+  BinaryReader(const uint8_t* _buffer, uint32_t _size) : buffer(_buffer), size(_size) {
 
   }
 
-  explicit BinaryReader(std::vector<uint8_t>& _buffer) : buffer((uint8_t*)_buffer.data()), size(_buffer.size()) { }
+  explicit BinaryReader(const std::vector<uint8_t>& _buffer) : buffer(_buffer.data()), size(_buffer.size()) { }
 
   template<typename T>
   T read() {
     assert(seek + sizeof(T) <= size);
-    T& obj = *(T*)(buffer + seek);
+    const T& obj = *(const T*)(buffer + seek);
     seek += sizeof(T);
     return obj;
   }
 
+  // copy count T's into dest.
+  template<typename T>
+  void read_array(T* dest, size_t count) {
+    assert(seek + sizeof(T) * count <= size);
+    if (count) {
+      memcpy(dest, buffer + seek, sizeof(T) * count);
+    }
+    seek += sizeof(T) * count;
+  }
+
+  // read a string written by BinaryWriter::add_string
+  std::string read_string() {
+    auto len = read<uint32_t>();
+    assert(seek + len <= size);
+    std::string result((const char*)(buffer + seek), len);
+    seek += len;
+    return result;
+  }
+
   void ffwd(int amount) {
     seek += amount;
     assert(seek <= size);
@@ -30,7 +51,7 @@ public:
     return size - seek;
   }
 
-  uint8_t* here() {
+  const uint8_t* here() {
     return buffer + seek;
   }
 
@@ -39,7 +60,7 @@ public:
   }
 
 private:
-  uint8_t* buffer;
+  const uint8_t* buffer;
   uint32_t size;
   uint32_t seek = 0;
 };
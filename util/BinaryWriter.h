@@ -0,0 +1,46 @@
+#ifndef JAK_DISASSEMBLER_BINARYWRITER_H
+#define JAK_DISASSEMBLER_BINARYWRITER_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*!
+ * Builds up a buffer of binary data, to be read back with a BinaryReader.
+ */
+class BinaryWriter {
+ public:
+  template <typename T>
+  void add(const T& obj) {
+    add_bytes(&obj, sizeof(T));
+  }
+
+  void add_bytes(const void* src, size_t size) {
+    auto offset = m_data.size();
+    m_data.resize(offset + size);
+    if (size) {
+      memcpy(m_data.data() + offset, src, size);
+    }
+  }
+
+  // overwrite something that was already added at the given offset.
+  template <typename T>
+  void set(size_t offset, const T& obj) {
+    memcpy(m_data.data() + offset, &obj, sizeof(T));
+  }
+
+  // strings are stored as a uint32_t length, then the characters, without a null terminator.
+  void add_string(const std::string& str) {
+    add<uint32_t>(str.size());
+    add_bytes(str.data(), str.size());
+  }
+
+  size_t size() const { return m_data.size(); }
+  const uint8_t* data() const { return m_data.data(); }
+
+ private:
+  std::vector<uint8_t> m_data;
+};
+
+#endif  // JAK_DISASSEMBLER_BINARYWRITER_H
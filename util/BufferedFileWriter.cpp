@@ -0,0 +1,143 @@
+#include "BufferedFileWriter.h"
+
+#include <cassert>
+#include <cstdarg>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+BufferedFileWriter::BufferedFileWriter(const std::string& file_name,
+                                       Mode mode,
+                                       size_t buffer_size)
+    : m_file_name(file_name), m_buffer(buffer_size) {
+#ifdef __linux__
+  if (mode == Mode::KEEP_IF_UNCHANGED) {
+    m_compare_fp = fopen(file_name.c_str(), "rb");
+    if (m_compare_fp) {
+      // nothing is written until the new content differs from the existing file.
+      return;
+    }
+  }
+#else
+  (void)mode;
+#endif
+
+  m_fp = fopen(file_name.c_str(), "w");
+  if (!m_fp) {
+    ::printf("Failed to fopen %s\n", file_name.c_str());
+    throw std::runtime_error("Failed to open file");
+  }
+}
+
+BufferedFileWriter::~BufferedFileWriter() {
+  if (m_compare_fp) {
+    fclose(m_compare_fp);
+  }
+  if (m_fp) {
+    // can't throw from here, so errors are only reported when close() is called.
+    fwrite(m_buffer.data(), 1, m_used, m_fp);
+    fclose(m_fp);
+  }
+}
+
+/*!
+ * The new content differs from the existing file. Everything before this point is the same, so
+ * open the file and start writing from here.
+ */
+void BufferedFileWriter::stop_comparing() {
+  fclose(m_compare_fp);
+  m_compare_fp = nullptr;
+  m_compare_buffer = std::vector<char>();
+  m_fp = fopen(m_file_name.c_str(), "r+b");
+  if (!m_fp || fseek(m_fp, m_bytes_flushed, SEEK_SET) != 0) {
+    throw std::runtime_error("Failed to open file " + m_file_name);
+  }
+}
+
+/*!
+ * Write (or compare) some bytes at m_bytes_flushed.
+ */
+void BufferedFileWriter::write_to_file(const char* str, size_t len) {
+  if (m_compare_fp) {
+    m_compare_buffer.resize(len);
+    if (fread(m_compare_buffer.data(), 1, len, m_compare_fp) == len &&
+        memcmp(m_compare_buffer.data(), str, len) == 0) {
+      m_bytes_flushed += len;
+      return;
+    }
+    stop_comparing();
+  }
+
+  if (fwrite(str, 1, len, m_fp) != len) {
+    throw std::runtime_error("Failed to write file " + m_file_name);
+  }
+  m_bytes_flushed += len;
+}
+
+/*!
+ * Write to the file when the buffer is too full. Big writes go straight to the file.
+ */
+void BufferedFileWriter::write_slow(const char* str, size_t len) {
+  flush();
+  if (len >= m_buffer.size()) {
+    write_to_file(str, len);
+  } else {
+    memcpy(m_buffer.data(), str, len);
+    m_used = len;
+  }
+}
+
+void BufferedFileWriter::write_spaces(size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    write(' ');
+  }
+}
+
+/*!
+ * printf into the file. The formatted text should be short.
+ */
+void BufferedFileWriter::printf(const char* format, ...) {
+  char buff[512];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buff, sizeof(buff), format, args);
+  va_end(args);
+  assert(len >= 0 && len < int(sizeof(buff)));
+  write(buff, len);
+}
+
+/*!
+ * Write everything in the buffer to the file.
+ */
+void BufferedFileWriter::flush() {
+  if (m_used) {
+    write_to_file(m_buffer.data(), m_used);
+    m_used = 0;
+  }
+}
+
+/*!
+ * Flush and close the file. No more writes are allowed after this.
+ */
+void BufferedFileWriter::close() {
+  flush();
+  if (m_compare_fp) {
+    if (fgetc(m_compare_fp) == EOF) {
+      // same content, and the existing file doesn't have anything extra.
+      return;
+    }
+    stop_comparing();
+  }
+
+  bool ok = fclose(m_fp) == 0;
+  m_fp = nullptr;
+#ifdef __linux__
+  // in case we overwrote a longer file.
+  ok = ok && truncate(m_file_name.c_str(), m_bytes_flushed) == 0;
+#endif
+  if (!ok) {
+    throw std::runtime_error("Failed to write file " + m_file_name);
+  }
+}
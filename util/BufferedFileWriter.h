@@ -0,0 +1,73 @@
+#ifndef JAK_DISASSEMBLER_BUFFEREDFILEWRITER_H
+#define JAK_DISASSEMBLER_BUFFEREDFILEWRITER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*!
+ * Writes text to a file through a fixed size buffer.
+ * This lets printers write their output in small pieces as they go, instead of building the whole
+ * file in a std::string first.
+ */
+class BufferedFileWriter {
+ public:
+  enum class Mode {
+    OVERWRITE,         // always replace the file
+    KEEP_IF_UNCHANGED  // if the file already has exactly this content, don't touch it
+  };
+
+  explicit BufferedFileWriter(const std::string& file_name,
+                              Mode mode = Mode::OVERWRITE,
+                              size_t buffer_size = 1 << 16);
+  ~BufferedFileWriter();
+  BufferedFileWriter(const BufferedFileWriter&) = delete;
+  BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+  void write(const char* str, size_t len) {
+    if (len > m_buffer.size() - m_used) {
+      write_slow(str, len);
+    } else {
+      memcpy(m_buffer.data() + m_used, str, len);
+      m_used += len;
+    }
+  }
+
+  void write(const std::string& str) { write(str.data(), str.size()); }
+  void write(const char* str) { write(str, strlen(str)); }
+
+  void write(char c) {
+    if (m_used == m_buffer.size()) {
+      flush();
+    }
+    m_buffer[m_used++] = c;
+  }
+
+  void write_spaces(size_t count);
+  void printf(const char* format, ...);
+
+  void flush();
+  void close();
+
+  uint64_t bytes_written() const { return m_bytes_flushed + m_used; }
+  // after close(), false if the file was left alone because its content was already the same.
+  bool file_changed() const { return m_compare_fp == nullptr; }
+
+ private:
+  void write_slow(const char* str, size_t len);
+  void write_to_file(const char* str, size_t len);
+  void stop_comparing();
+
+  std::string m_file_name;
+  FILE* m_fp = nullptr;
+  // in KEEP_IF_UNCHANGED mode, the existing file, which we compare against until it differs.
+  FILE* m_compare_fp = nullptr;
+  std::vector<char> m_compare_buffer;
+  std::vector<char> m_buffer;
+  size_t m_used = 0;
+  uint64_t m_bytes_flushed = 0;
+};
+
+#endif  // JAK_DISASSEMBLER_BUFFEREDFILEWRITER_H
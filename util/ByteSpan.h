@@ -0,0 +1,40 @@
+#ifndef JAK_DISASSEMBLER_BYTESPAN_H
+#define JAK_DISASSEMBLER_BYTESPAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+/*!
+ * A non-owning view of some bytes. Whoever owns the bytes must keep them alive.
+ * Has the same at() / size() / data() interface as a const std::vector<uint8_t>.
+ */
+class ByteSpan {
+ public:
+  ByteSpan() = default;
+  ByteSpan(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+  explicit ByteSpan(const std::vector<uint8_t>& data) : m_data(data.data()), m_size(data.size()) {}
+
+  const uint8_t* data() const { return m_data; }
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  const uint8_t* begin() const { return m_data; }
+  const uint8_t* end() const { return m_data + m_size; }
+
+  const uint8_t& operator[](size_t idx) const { return m_data[idx]; }
+
+  const uint8_t& at(size_t idx) const {
+    if (idx >= m_size) {
+      throw std::out_of_range("ByteSpan::at");
+    }
+    return m_data[idx];
+  }
+
+ private:
+  const uint8_t* m_data = nullptr;
+  size_t m_size = 0;
+};
+
+#endif  // JAK_DISASSEMBLER_BYTESPAN_H
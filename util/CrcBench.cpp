@@ -0,0 +1,102 @@
+/*!
+ * @file CrcBench.cpp
+ * Check the slicing-by-8 crc32 against the original byte at a time version, and compare how fast
+ * they are.
+ */
+
+#include "CrcBench.h"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "util/FileIO.h"
+#include "util/Timer.h"
+
+namespace {
+constexpr size_t LARGE_SIZE = 64 << 20;
+constexpr int RUNS = 5;
+
+/*!
+ * Fill a buffer with pseudo-random bytes, the same every run.
+ */
+std::vector<uint8_t> make_random_data(size_t size) {
+  std::vector<uint8_t> result(size);
+  uint64_t state = 0x123456789abcdefull;
+  for (auto& x : result) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    x = uint8_t(state >> 32);
+  }
+  return result;
+}
+
+/*!
+ * Check every length up to max_size, starting at every alignment within 8 bytes. Returns the
+ * number of lengths and alignments where the two versions disagree.
+ */
+int count_mismatches(const std::vector<uint8_t>& data, size_t max_size) {
+  int mismatches = 0;
+  for (size_t offset = 0; offset < 8; offset++) {
+    for (size_t size = 0; size <= max_size; size++) {
+      if (crc32(data.data() + offset, size) != crc32_reference(data.data() + offset, size)) {
+        mismatches++;
+      }
+    }
+  }
+  return mismatches;
+}
+
+/*!
+ * Hash data in pieces of the given size, and return the best time of a few runs in seconds.
+ */
+template <typename Func>
+double best_time(const std::vector<uint8_t>& data, size_t piece_size, Func crc, uint32_t* result) {
+  double best = -1;
+  for (int run = 0; run < RUNS; run++) {
+    uint32_t combined = 0;
+    Timer timer;
+    for (size_t offset = 0; offset + piece_size <= data.size(); offset += piece_size) {
+      combined ^= crc(data.data() + offset, piece_size);
+    }
+    double seconds = timer.getSeconds();
+    if (best < 0 || seconds < best) {
+      best = seconds;
+    }
+    *result = combined;
+  }
+  return best;
+}
+}  // namespace
+
+/*!
+ * Compare crc32 with crc32_reference, on every small length and alignment and on a large buffer
+ * hashed in pieces of a few different sizes. Prints the throughput of both.
+ */
+void run_crc_bench() {
+  printf("- Benchmarking crc32...\n");
+  auto data = make_random_data(LARGE_SIZE);
+  int mismatches = count_mismatches(data, 300);
+
+  printf("Benchmarked crc32:\n");
+  printf(" %d mismatches on lengths 0 to 300 at 8 alignments\n", mismatches);
+  printf(" %.3f MB of data, best of %d runs\n", LARGE_SIZE / (double)(1u << 20u), RUNS);
+  printf(" %12s %16s %16s %9s %8s\n", "piece bytes", "reference MB/s", "sliced MB/s", "speedup",
+         "check");
+  for (size_t piece_size : {size_t(64), size_t(1) << 10, size_t(16) << 10, LARGE_SIZE}) {
+    uint32_t reference_result = 0, sliced_result = 0;
+    double reference_seconds = best_time(data, piece_size, crc32_reference, &reference_result);
+    double sliced_seconds = best_time(
+        data, piece_size, [](const uint8_t* d, size_t s) { return crc32(d, s); }, &sliced_result);
+    double mb = LARGE_SIZE / (double)(1u << 20u);
+    printf(" %12d %16.1f %16.1f %8.2fx %8s\n", int(piece_size), mb / reference_seconds,
+           mb / sliced_seconds, reference_seconds / sliced_seconds,
+           reference_result == sliced_result ? "ok" : "FAILED");
+    if (reference_result != sliced_result) {
+      mismatches++;
+    }
+  }
+  if (mismatches) {
+    printf("crc32 and crc32_reference gave different results!\n");
+  }
+  printf("\n");
+}
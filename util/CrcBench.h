@@ -0,0 +1,12 @@
+/*!
+ * @file CrcBench.h
+ * Check the slicing-by-8 crc32 against the original byte at a time version, and compare how fast
+ * they are.
+ */
+
+#ifndef JAK_DISASSEMBLER_CRCBENCH_H
+#define JAK_DISASSEMBLER_CRCBENCH_H
+
+void run_crc_bench();
+
+#endif  // JAK_DISASSEMBLER_CRCBENCH_H
@@ -45,32 +45,89 @@ std::string base_name(const std::string& filename) {
 }
 
 static bool sInitCrc = false;
-static uint32_t crc_table[0x100];
+// crc_table[k][b] is b * x^(32 + 8k) mod the polynomial, so crc_table[0] is the usual byte table
+// and the others let us handle 8 bytes at a time.
+static uint32_t crc_table[8][0x100];
 
 void init_crc() {
   for (uint32_t i = 0; i < 0x100; i++) {
     uint32_t n = i << 24u;
     for (uint32_t j = 0; j < 8; j++)
       n = n & 0x80000000 ? (n << 1u) ^ 0x04c11db7u : (n << 1u);
-    crc_table[i] = n;
+    crc_table[0][i] = n;
+  }
+
+  for (uint32_t k = 1; k < 8; k++) {
+    for (uint32_t i = 0; i < 0x100; i++) {
+      uint32_t prev = crc_table[k - 1][i];
+      crc_table[k][i] = crc_table[0][prev >> 24u] ^ (prev << 8u);
+    }
   }
   sInitCrc = true;
 }
 
+/*!
+ * This crc shifts each byte into the bottom of the register, so the result is the message mod the
+ * polynomial.  That's the same as the usual crc (message * x^32 mod polynomial) of all but the
+ * last 4 bytes, xor'd with the last 4 bytes.  The usual crc can be done 8 bytes at a time
+ * ("slicing-by-8"), which is much faster than going byte by byte.
+ */
 uint32_t crc32(const uint8_t* data, size_t size) {
   assert(sInitCrc);
+  size_t tail_size = size < 4 ? size : 4;
+  const uint8_t* tail = data + size - tail_size;
+
   uint32_t crc = 0;
-  for (size_t i = size; i != 0; i--, data++) {
-    crc = crc_table[crc >> 24u] ^ ((crc << 8u) | *data);
+  while (data + 8 <= tail) {
+    uint32_t hi = crc ^ ((uint32_t(data[0]) << 24u) | (uint32_t(data[1]) << 16u) |
+                         (uint32_t(data[2]) << 8u) | data[3]);
+    crc = crc_table[7][hi >> 24u] ^ crc_table[6][(hi >> 16u) & 0xff] ^
+          crc_table[5][(hi >> 8u) & 0xff] ^ crc_table[4][hi & 0xff] ^ crc_table[3][data[4]] ^
+          crc_table[2][data[5]] ^ crc_table[1][data[6]] ^ crc_table[0][data[7]];
+    data += 8;
+  }
+
+  while (data < tail) {
+    crc = crc_table[0][(crc >> 24u) ^ *data] ^ (crc << 8u);
+    data++;
+  }
+
+  for (size_t i = 0; i < tail_size; i++) {
+    crc ^= uint32_t(tail[i]) << (8u * (tail_size - 1 - i));
   }
   return ~crc;
 }
 
+/*!
+ * The original version of crc32, which goes one byte at a time. Kept to check and benchmark the
+ * fast version against.
+ */
+uint32_t crc32_reference(const uint8_t* data, size_t size) {
+  assert(sInitCrc);
+  uint32_t crc = 0;
+  for (size_t i = size; i != 0; i--, data++) {
+    crc = crc_table[0][crc >> 24u] ^ ((crc << 8u) | *data);
+  }
+  return ~crc;
+}
 
 uint32_t crc32(const std::vector<uint8_t>& data) {
   return crc32(data.data(), data.size());
 }
 
+/*!
+ * 64-bit FNV-1a hash. Used along with the crc32 when we need to be sure two object files are the
+ * same without having both of them to compare.
+ */
+uint64_t hash64(const uint8_t* data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
 void write_text_file(const std::string& file_name, const std::string& text) {
   FILE* fp = fopen(file_name.c_str(), "w");
   if(!fp) {
@@ -79,4 +136,33 @@ void write_text_file(const std::string& file_name, const std::string& text) {
   }
   fprintf(fp, "%s\n", text.c_str());
   fclose(fp);
-}
\ No newline at end of file
+}
+/*!
+ * Like write_text_file, but if the file already has this content, leave it alone so its
+ * modification time doesn't change. Returns true if the file was written.
+ */
+bool write_text_file_if_changed(const std::string& file_name, const std::string& text) {
+  if (file_exists(file_name) && read_text_file(file_name) == text + "\n") {
+    return false;
+  }
+  write_text_file(file_name, text);
+  return true;
+}
+
+bool file_exists(const std::string& path) {
+  std::ifstream file(path);
+  return file.good();
+}
+
+void write_binary_file(const std::string& file_name, const void* data, size_t size) {
+  FILE* fp = fopen(file_name.c_str(), "wb");
+  if (!fp) {
+    printf("Failed to fopen %s\n", file_name.c_str());
+    throw std::runtime_error("Failed to open file");
+  }
+  if (fwrite(data, 1, size, fp) != size) {
+    fclose(fp);
+    throw std::runtime_error("Failed to write file " + file_name);
+  }
+  fclose(fp);
+}
@@ -9,9 +9,14 @@ std::string combine_path(const std::string& parent, const std::string& child);
 std::vector<uint8_t> read_binary_file(const std::string& filename);
 std::string base_name(const std::string& filename);
 void write_text_file(const std::string& file_name, const std::string& text);
+bool write_text_file_if_changed(const std::string& file_name, const std::string& text);
+bool file_exists(const std::string& path);
+void write_binary_file(const std::string& file_name, const void* data, size_t size);
 
 void init_crc();
 uint32_t crc32(const uint8_t* data, size_t size);
 uint32_t crc32(const std::vector<uint8_t>& data);
+uint32_t crc32_reference(const uint8_t* data, size_t size);
+uint64_t hash64(const uint8_t* data, size_t size);
 
 #endif //JAK_V2_FILEIO_H
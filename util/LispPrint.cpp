@@ -1,24 +1,38 @@
 #include "LispPrint.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <vector>
 
-//////// HACK - symbol table now looks up by string, which makes it really stupid and store
-// all strings twice.
-// should probably just remove it
+/*!
+ * String interning. Safe to call from any thread.
+ */
+const std::string* SymbolTable::intern(const std::string& str) {
+  // the shard uses the high bits, and the map uses the hash mod its (prime) bucket count. The string
+  // is only hashed here: inside the lock, just strings with the same hash are compared.
+  auto hash = std::hash<std::string>()(str);
+  auto& shard = shards[hash >> (8 * sizeof(size_t) - SHARD_BITS)];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto range = shard.strings.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == str) {
+      return &it->second;
+    }
+  }
+  return &shard.strings.emplace(hash, str)->second;
+}
 
 /*!
- * String interning
+ * Number of interned strings.
  */
-std::string* SymbolTable::intern(const std::string& str) {
-  if (map.find(str) == map.end()) {
-    auto* new_string = new std::string(str);
-    map[str] = new_string;
-    return new_string;
-  } else {
-    return map[str];
+size_t SymbolTable::size() {
+  size_t result = 0;
+  for (auto& shard : shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    result += shard.strings.size();
   }
+  return result;
 }
 
 /*!
@@ -27,14 +41,12 @@ std::string* SymbolTable::intern(const std::string& str) {
 SymbolTable gSymbolTable;
 
 SymbolTable::SymbolTable() {
-  empty_pair = std::make_shared<Form>();
-  empty_pair->kind = FormKind::EMPTY_LIST;
+  empty_pair.kind = FormKind::EMPTY_LIST;
+  empty_pair.symbol = nullptr;
+  empty_pair.pair[0] = nullptr;
+  empty_pair.pair[1] = nullptr;
 }
 
-SymbolTable::~SymbolTable() {
-  for (const auto& kv : map)
-    delete kv.second;
-}
 
 /*!
  * Convert a form to a one-line string.
@@ -89,7 +101,7 @@ void Form::toTokenList(std::vector<FormToken> &tokens) {
       for(;;) {
         if(toPrint->kind == FormKind::PAIR) {
           toPrint->pair[0]->toTokenList(tokens); // print CAR
-          toPrint = toPrint->pair[1].get();
+          toPrint = toPrint->pair[1];
           if(toPrint->kind == FormKind::EMPTY_LIST) {
             tokens.emplace_back(TokenKind::CLOSE_PAREN);
             return;
@@ -119,6 +131,8 @@ void Form::toTokenList(std::vector<FormToken> &tokens) {
 // Pretty Printer
 ///////////////////
 
+// The reference printer works on a linked list of tokens and line separators.
+
 /*!
  * Linked list node representing a token in the output (whitespace, paren, newline, etc)
  */
@@ -140,9 +154,9 @@ struct PrettyPrinterNode {
 /*!
  * Splice in a line break after the given node, it there isn't one already and if it isn't the last node.
  */
-static void insertNewlineAfter(PrettyPrinterNode* node, int specialIndentDelta) {
+static void insertNewlineAfter(Arena& arena, PrettyPrinterNode* node, int specialIndentDelta) {
   if(node->next && !node->next->is_line_separator) {
-    auto* nl = new PrettyPrinterNode;
+    auto* nl = arena.make<PrettyPrinterNode>();
     auto* next = node->next;
     node->next = nl;
     nl->prev = node;
@@ -156,9 +170,9 @@ static void insertNewlineAfter(PrettyPrinterNode* node, int specialIndentDelta)
 /*!
  * Splice in a line break before the given node, if there isn't one already and if it isn't the first node.
  */
-static void insertNewlineBefore(PrettyPrinterNode* node, int specialIndentDelta) {
+static void insertNewlineBefore(Arena& arena, PrettyPrinterNode* node, int specialIndentDelta) {
   if(node->prev && !node->prev->is_line_separator) {
-    auto* nl = new PrettyPrinterNode;
+    auto* nl = arena.make<PrettyPrinterNode>();
     auto* prev = node->prev;
     prev->next = nl;
     nl->prev = prev;
@@ -172,7 +186,7 @@ static void insertNewlineBefore(PrettyPrinterNode* node, int specialIndentDelta)
 /*!
  * Break a list across multiple lines. This is the fundamental reducing operation of this algorithm
  */
-static void breakList(PrettyPrinterNode* leftParen) {
+static void breakList(Arena& arena, PrettyPrinterNode* leftParen) {
   assert(!leftParen->is_line_separator);
   assert(leftParen->tok->kind == TokenKind::OPEN_PAREN);
   auto* rp = leftParen->paren;
@@ -183,10 +197,10 @@ static void breakList(PrettyPrinterNode* leftParen) {
       if(n->tok->kind == TokenKind::OPEN_PAREN) {
         n = n->paren;
         assert(n->tok->kind == TokenKind::CLOSE_PAREN);
-        insertNewlineAfter(n, 0);
+        insertNewlineAfter(arena, n, 0);
       } else if(n->tok->kind != TokenKind::WHITESPACE) {
         assert(n->tok->kind != TokenKind::CLOSE_PAREN);
-        insertNewlineAfter(n, 0);
+        insertNewlineAfter(arena, n, 0);
       }
     }
   }
@@ -196,7 +210,7 @@ static void breakList(PrettyPrinterNode* leftParen) {
  * Compute proper line numbers, offsets, and indents for a list of tokens with newlines
  * Will add newlines for close parens if needed.
  */
-static PrettyPrinterNode* propagatePretty(PrettyPrinterNode* list, int line_length) {
+static PrettyPrinterNode* propagatePretty(Arena& arena, PrettyPrinterNode* list, int line_length) {
   // propagate line numbers
   PrettyPrinterNode* rv = nullptr;
   int line = list->line;
@@ -209,11 +223,11 @@ static PrettyPrinterNode* propagatePretty(PrettyPrinterNode* list, int line_leng
       if(n->tok->kind == TokenKind::CLOSE_PAREN) {
         if(n->line != n->paren->line) {
           if(n->prev && !n->prev->is_line_separator) {
-            insertNewlineBefore(n, 0);
+            insertNewlineBefore(arena, n, 0);
             line++;
           }
           if(n->next && !n->next->is_line_separator) {
-            insertNewlineAfter(n, 0);
+            insertNewlineAfter(arena, n, 0);
           }
         }
       }
@@ -339,7 +353,7 @@ static PrettyPrinterNode* getFirstBadLine(PrettyPrinterNode* start, int line_len
 /*!
  * Break insertion algorithm.
  */
-static void insertBreaksAsNeeded(PrettyPrinterNode* head, int line_length) {
+static void insertBreaksAsNeeded(Arena& arena, PrettyPrinterNode* head, int line_length) {
   PrettyPrinterNode* last_line_complete = nullptr;
   PrettyPrinterNode* line_to_start_line_search = head;
 
@@ -347,7 +361,7 @@ static void insertBreaksAsNeeded(PrettyPrinterNode* head, int line_length) {
   for(;;) {
 
     // compute lines as needed
-    propagatePretty(head, line_length);
+    propagatePretty(arena, head, line_length);
 
     // search for a bad line starting at the last line we fixed
     PrettyPrinterNode* candidate_line = getFirstBadLine(line_to_start_line_search, line_length);
@@ -365,8 +379,8 @@ static void insertBreaksAsNeeded(PrettyPrinterNode* head, int line_length) {
     assert(!candidate_line->prev || candidate_line->prev->is_line_separator);
     PrettyPrinterNode* form_to_start = getFirstListOnLine(candidate_line);
     for(;;) {
-      breakList(form_to_start);
-      propagatePretty(head, line_length);
+      breakList(arena, form_to_start);
+      propagatePretty(arena, head, line_length);
       if(getFirstBadLine(candidate_line, line_length) != candidate_line) {
         break;
       }
@@ -382,21 +396,28 @@ static void insertBreaksAsNeeded(PrettyPrinterNode* head, int line_length) {
   }
 }
 
-static void insertSpecialBreaks(PrettyPrinterNode* node) {
+static void insertSpecialBreaks(Arena& arena, PrettyPrinterNode* node) {
   for(; node; node = node->next) {
     if(!node->is_line_separator && node->tok->kind == TokenKind::SYMBOL) {
-      std::string& name = *node->tok->str;
+      const std::string& name = *node->tok->str;
       if(name == "deftype") {
         auto* parent_type_dec = getNextListOnLine(node);
         if(parent_type_dec) {
-          insertNewlineAfter(parent_type_dec->paren, 0);
+          insertNewlineAfter(arena, parent_type_dec->paren, 0);
         }
       }
     }
   }
 }
 
-std::string Form::toStringPretty(int indent, int line_length) {
+/*!
+ * The original pretty printer. It finds the first line that is too long, breaks lists on it, and
+ * lays out the whole form again, until no line can be fixed. This is quadratic or worse for big
+ * forms, so it isn't used for output, but it is the definition of where the breaks go, and
+ * toStringPretty is checked against it.
+ */
+std::string Form::toStringPrettyReference(int indent, int line_length) {
+  Arena arena;
   (void)indent;
   (void)line_length;
   std::vector<FormToken> tokens;
@@ -405,14 +426,14 @@ std::string Form::toStringPretty(int indent, int line_length) {
   std::string pretty;
 
   // build linked list of nodes
-  PrettyPrinterNode* head = new PrettyPrinterNode(tokens[0]);
+  PrettyPrinterNode* head = arena.make<PrettyPrinterNode>(tokens[0]);
   PrettyPrinterNode* node = head;
   head->line = 0;
   head->offset = 0;
   head->lineIndent = 0;
   int offset = head->tok->toString().length();
   for(size_t i = 1; i < tokens.size(); i++) {
-    node->next = new PrettyPrinterNode(tokens[i]);
+    node->next = arena.make<PrettyPrinterNode>(tokens[i]);
     node->next->prev = node;
     node = node->next;
     node->line = 0;
@@ -438,9 +459,9 @@ std::string Form::toStringPretty(int indent, int line_length) {
   assert(parenStack.size() == 1);
   assert(!parenStack.back());
 
-  insertSpecialBreaks(head);
-  propagatePretty(head, line_length);
-  insertBreaksAsNeeded(head, line_length);
+  insertSpecialBreaks(arena, head);
+  propagatePretty(arena, head, line_length);
+  insertBreaksAsNeeded(arena, head, line_length);
 
 
   // write to string
@@ -459,52 +480,182 @@ std::string Form::toStringPretty(int indent, int line_length) {
     }
   }
 
-  for(;;) {
-    if(!head) break;
-    auto* next = head->next;
-    delete head;
-    head = next;
+  return pretty;
+}
+
+/*!
+ * Pretty print with the same line breaks as toStringPrettyReference, in a single pass.
+ *
+ * The reference printer only ever fixes the first bad line, and breaking lists on a line never
+ * changes the lines before it. So this works like a streaming (Oppen style) printer: each line is
+ * decided once, from left to right, then printed and never looked at again. Breaks are flags
+ * between tokens instead of nodes in a list, and token widths come from a prefix sum, so the
+ * width of any part of a line is a subtraction. Each list is broken at most once, and finding the
+ * end of a line is linear in its length, so the whole thing is linear in the number of tokens.
+ */
+std::string Form::toStringPretty(int indent, int line_length) {
+  (void)indent;
+  std::vector<FormToken> tokens;
+  toTokenList(tokens);
+  assert(!tokens.empty());
+  size_t n = tokens.size();
+
+  // start[i] is where token i would be if everything was on one line.
+  std::vector<int> start(n + 1, 0);
+  // for parens, the index of the matching paren.
+  std::vector<size_t> paren(n, 0);
+  // there is a line break between token i and token i + 1.
+  std::vector<uint8_t> break_after(n, 0);
+
+  std::vector<size_t> paren_stack;
+  for (size_t i = 0; i < n; i++) {
+    start[i + 1] = start[i] + tokens[i].width();
+    if (tokens[i].kind == TokenKind::OPEN_PAREN) {
+      paren_stack.push_back(i);
+    } else if (tokens[i].kind == TokenKind::CLOSE_PAREN) {
+      assert(!paren_stack.empty());
+      paren[i] = paren_stack.back();
+      paren[paren_stack.back()] = i;
+      paren_stack.pop_back();
+    }
   }
+  assert(paren_stack.empty());
 
+  auto set_break_after = [&](size_t i) {
+    if (i + 1 < n) {
+      break_after[i] = 1;
+    }
+  };
+
+  // special case: break after the parent type of a deftype
+  for (size_t i = 0; i < n; i++) {
+    if (tokens[i].kind == TokenKind::SYMBOL && *tokens[i].str == "deftype") {
+      for (size_t j = i + 1; j < n && !break_after[j - 1]; j++) {
+        if (tokens[j].kind == TokenKind::OPEN_PAREN) {
+          set_break_after(paren[j]);
+          break;
+        }
+      }
+    }
+  }
+
+  // break after each element of a list, including the last, so the close paren gets its own line.
+  auto break_list = [&](size_t open) {
+    assert(tokens[open].kind == TokenKind::OPEN_PAREN);
+    for (size_t i = open + 1; i < paren[open]; i++) {
+      if (tokens[i].kind == TokenKind::OPEN_PAREN) {
+        i = paren[i];
+        set_break_after(i);
+      } else if (tokens[i].kind != TokenKind::WHITESPACE) {
+        assert(tokens[i].kind != TokenKind::CLOSE_PAREN);
+        set_break_after(i);
+      }
+    }
+  };
+
+  // find the last token on the line starting at line_start. A close paren of a list that started
+  // on an earlier line always goes on a line by itself.
+  auto find_line_end = [&](size_t line_start) {
+    if (tokens[line_start].kind == TokenKind::CLOSE_PAREN) {
+      set_break_after(line_start);
+      return line_start;
+    }
+    size_t i = line_start;
+    while (i + 1 < n && !break_after[i]) {
+      if (tokens[i + 1].kind == TokenKind::CLOSE_PAREN && paren[i + 1] < line_start) {
+        set_break_after(i);
+        break;
+      }
+      i++;
+    }
+    return i;
+  };
+
+  std::string pretty;
+  pretty.reserve(start[n] + n);
+  std::vector<int> indent_stack = {0};
+  size_t line_start = 0;
+  while (line_start < n) {
+    int line_indent = indent_stack.back();
+    auto offset_of = [&](size_t i) { return line_indent + start[i] - start[line_start]; };
+    size_t line_end = find_line_end(line_start);
+
+    // the line is too long if a token starts past the end. Like the reference, break the first
+    // list on the line, then the list that is its first element, and so on, until the line fits.
+    if (offset_of(line_end) > line_length) {
+      size_t list = line_start;
+      while (list <= line_end && tokens[list].kind != TokenKind::OPEN_PAREN) {
+        list++;
+      }
+
+      while (list <= line_end) {
+        break_list(list);
+        // the line now ends after the first element of the list.
+        size_t first = list + 1;
+        size_t first_end = tokens[first].kind == TokenKind::OPEN_PAREN ? paren[first] : first;
+        line_end = std::min(line_end, first_end);
+        if (offset_of(line_end) <= line_length || tokens[first].kind != TokenKind::OPEN_PAREN) {
+          break;
+        }
+        list = first;
+      }
+    }
+
+    // print the line, and find the indent for lists that are opened on it.
+    pretty.append(line_indent, ' ');
+    for (size_t i = line_start; i <= line_end; i++) {
+      // a line can start with the space between list elements, which isn't printed, but still
+      // counts toward the offsets of everything after it.
+      if (i != line_start || tokens[i].kind != TokenKind::WHITESPACE) {
+        tokens[i].append_to(pretty);
+      }
+      if (tokens[i].kind == TokenKind::OPEN_PAREN) {
+        indent_stack.push_back(offset_of(i) + (i == line_start ? 2 : 0));
+      } else if (tokens[i].kind == TokenKind::CLOSE_PAREN) {
+        indent_stack.pop_back();
+      }
+    }
+
+    line_start = line_end + 1;
+    if (line_start < n) {
+      pretty.push_back('\n');
+    }
+  }
 
   return pretty;
 }
 
-std::shared_ptr<Form> toForm(const std::string& str) {
-  auto f = std::make_shared<Form>();
+Form* toForm(Arena& arena, const std::string& str) {
+  auto* f = arena.make<Form>();
   f->kind = FormKind::SYMBOL;
   f->symbol = gSymbolTable.intern(str);
   return f;
 }
 
-std::shared_ptr<Form> buildList(std::shared_ptr<Form> form) {
-  auto f = std::make_shared<Form>();
+Form* buildPair(Arena& arena, Form* car, Form* cdr) {
+  auto* f = arena.make<Form>();
   f->kind = FormKind::PAIR;
-  f->pair[0] = form;
-  f->pair[1] = gSymbolTable.getEmptyPair();
+  f->pair[0] = car;
+  f->pair[1] = cdr;
   return f;
 }
 
-std::shared_ptr<Form> buildList(const std::string& str) {
-  return buildList(toForm(str));
+Form* buildList(Arena& arena, Form* form) {
+  return buildPair(arena, form, gSymbolTable.getEmptyPair());
 }
 
-std::shared_ptr<Form> buildList(std::shared_ptr<Form>* forms, int count) {
-  auto f = std::make_shared<Form>();
-  f->kind = FormKind::PAIR;
-  f->pair[0] = forms[0];
-  if(count - 1) {
-    f->pair[1] = buildList(forms + 1, count - 1);
-  } else {
-    f->pair[1] = gSymbolTable.getEmptyPair();
-  }
-
-  return f;
+Form* buildList(Arena& arena, const std::string& str) {
+  return buildList(arena, toForm(arena, str));
 }
 
-std::shared_ptr<Form> buildList(std::vector<std::shared_ptr<Form>>& forms) {
-  if(forms.empty()) {
-    return gSymbolTable.getEmptyPair();
+Form* buildList(Arena& arena, Form** forms, int count) {
+  Form* result = gSymbolTable.getEmptyPair();
+  for(int i = count; i-- > 0;) {
+    result = buildPair(arena, forms[i], result);
   }
-  return buildList(forms.data(), forms.size());
+  return result;
+}
+
+Form* buildList(Arena& arena, std::vector<Form*>& forms) {
+  return buildList(arena, forms.data(), forms.size());
 }
@@ -1,11 +1,12 @@
 #ifndef JAK2_DISASSEMBLER_LISPPRINT_H
 #define JAK2_DISASSEMBLER_LISPPRINT_H
 
-#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include "util/Arena.h"
 
 /*!
  * What type of thing is it?
@@ -38,11 +39,11 @@ enum class TokenKind {
  * Token in a text representation
  */
 struct FormToken {
-  explicit FormToken(TokenKind _kind, std::string* _str = nullptr) : kind(_kind), str(_str) {}
+  explicit FormToken(TokenKind _kind, const std::string* _str = nullptr) : kind(_kind), str(_str) {}
 
   TokenKind kind;
   union {
-    std::string* str;
+    const std::string* str;
   };
 
   std::string toString() {
@@ -74,20 +75,63 @@ struct FormToken {
     }
     return s;
   }
+
+  /*!
+   * Length of toString(), without building the string.
+   */
+  int width() const {
+    switch (kind) {
+      case TokenKind::SYMBOL:
+      case TokenKind::SPECIAL_SYMBOL:
+        return int(str->length());
+      case TokenKind::EMPTY_PAIR:
+        return 2;
+      default:
+        return 1;
+    }
+  }
+
+  void append_to(std::string& dest) const {
+    switch (kind) {
+      case TokenKind::WHITESPACE:
+        dest.push_back(' ');
+        break;
+      case TokenKind::SYMBOL:
+      case TokenKind::SPECIAL_SYMBOL:
+        dest.append(*str);
+        break;
+      case TokenKind::OPEN_PAREN:
+        dest.push_back('(');
+        break;
+      case TokenKind::DOT:
+        dest.push_back('.');
+        break;
+      case TokenKind::CLOSE_PAREN:
+        dest.push_back(')');
+        break;
+      case TokenKind::EMPTY_PAIR:
+        dest.append("()");
+        break;
+      default:
+        throw std::runtime_error("append_to unknown token kind");
+    }
+  }
 };
 
 /*!
  * S-Expression Form
+ * Forms are allocated in an Arena, and don't own the forms they point to.
  */
 class Form {
  public:
   FormKind kind;
 
-  std::string* symbol;
-  std::shared_ptr<Form> pair[2];
+  const std::string* symbol;
+  Form* pair[2];
 
   std::string toStringSimple();
   std::string toStringPretty(int indent = 0, int line_length = 80);
+  std::string toStringPrettyReference(int indent = 0, int line_length = 80);
   void toTokenList(std::vector<FormToken>& tokens);
 
  private:
@@ -96,17 +140,35 @@ class Form {
 
 /*!
  * Symbol table to reduce the number of strings everywhere.
+ * Interning is thread safe. The strings are split into shards by hash, each with its own lock, so
+ * threads interning different strings rarely wait for each other. Strings are never removed, and
+ * the set nodes never move, so interned pointers are valid for as long as the table exists.
  */
 class SymbolTable {
  public:
   SymbolTable();
-  std::string* intern(const std::string& str);
-  ~SymbolTable();
-  std::shared_ptr<Form> getEmptyPair() { return empty_pair; }
+  SymbolTable(const SymbolTable&) = delete;
+  SymbolTable& operator=(const SymbolTable&) = delete;
+  const std::string* intern(const std::string& str);
+  size_t size();
+  Form* getEmptyPair() { return &empty_pair; }
 
  private:
-  std::unordered_map<std::string, std::string*> map;
-  std::shared_ptr<Form> empty_pair;
+  static constexpr int SHARD_BITS = 6;
+  static constexpr size_t SHARD_COUNT = size_t(1) << SHARD_BITS;
+  // the strings are keyed by their hash, which is computed once, before taking the lock.
+  struct PrecomputedHash {
+    size_t operator()(size_t hash) const { return hash; }
+  };
+
+  // each shard gets its own cache line, so locking one doesn't slow down its neighbors.
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    std::unordered_multimap<size_t, std::string, PrecomputedHash> strings;
+  };
+
+  Shard shards[SHARD_COUNT];
+  Form empty_pair;
 };
 
 /*!
@@ -114,29 +176,22 @@ class SymbolTable {
  */
 extern SymbolTable gSymbolTable;
 
-std::shared_ptr<Form> toForm(const std::string& str);  //
+Form* toForm(Arena& arena, const std::string& str);
+Form* buildPair(Arena& arena, Form* car, Form* cdr);
 
-std::shared_ptr<Form> buildList(const std::string& str);
-std::shared_ptr<Form> buildList(std::shared_ptr<Form> form);
-std::shared_ptr<Form> buildList(std::vector<std::shared_ptr<Form>>& forms);
-std::shared_ptr<Form> buildList(std::shared_ptr<Form>* forms, int count);
+Form* buildList(Arena& arena, const std::string& str);
+Form* buildList(Arena& arena, Form* form);
+Form* buildList(Arena& arena, std::vector<Form*>& forms);
+Form* buildList(Arena& arena, Form** forms, int count);
 
 template <typename... Args>
-std::shared_ptr<Form> buildList(const std::string& str, Args... rest) {
-  auto f = std::make_shared<Form>();
-  f->kind = FormKind::PAIR;
-  f->pair[0] = toForm(str);
-  f->pair[1] = buildList(rest...);
-  return f;
+Form* buildList(Arena& arena, const std::string& str, Args... rest) {
+  return buildPair(arena, toForm(arena, str), buildList(arena, rest...));
 }
 
 template <typename... Args>
-std::shared_ptr<Form> buildList(std::shared_ptr<Form> car, Args... rest) {
-  auto f = std::make_shared<Form>();
-  f->kind = FormKind::PAIR;
-  f->pair[0] = car;
-  f->pair[1] = buildList(rest...);
-  return f;
+Form* buildList(Arena& arena, Form* car, Args... rest) {
+  return buildPair(arena, car, buildList(arena, rest...));
 }
 
 #endif  // JAK2_DISASSEMBLER_LISPPRINT_H
@@ -0,0 +1,54 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+#include "FileIO.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& filename) {
+#ifdef __linux__
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("File " + filename + " cannot be opened");
+  }
+
+  struct stat st = {};
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error("File " + filename + " cannot be read");
+  }
+
+  m_size = st.st_size;
+  if (m_size) {
+    void* mem = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mem == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("File " + filename + " cannot be mapped");
+    }
+    // we read these front to back.
+    madvise(mem, m_size, MADV_SEQUENTIAL);
+    m_mapping = mem;
+    m_data = (const uint8_t*)mem;
+  }
+
+  // the mapping stays valid after the file is closed.
+  close(fd);
+#else
+  m_fallback_data = read_binary_file(filename);
+  m_data = m_fallback_data.data();
+  m_size = m_fallback_data.size();
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef __linux__
+  if (m_mapping) {
+    munmap(m_mapping, m_size);
+  }
+#endif
+}
@@ -0,0 +1,32 @@
+#ifndef JAK_DISASSEMBLER_MAPPEDFILE_H
+#define JAK_DISASSEMBLER_MAPPEDFILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ByteSpan.h"
+
+/*!
+ * A read-only file, mapped into memory.
+ * Pages are loaded by the OS as they are used, and are backed by the file, so they don't count
+ * against our heap. On platforms without mmap, the file is just read into a buffer.
+ */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& filename);
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const uint8_t* data() const { return m_data; }
+  size_t size() const { return m_size; }
+  ByteSpan span() const { return ByteSpan(m_data, m_size); }
+
+ private:
+  const uint8_t* m_data = nullptr;
+  size_t m_size = 0;
+  void* m_mapping = nullptr;
+  std::vector<uint8_t> m_fallback_data;
+};
+
+#endif  // JAK_DISASSEMBLER_MAPPEDFILE_H
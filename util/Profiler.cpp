@@ -0,0 +1,177 @@
+/*!
+ * @file Profiler.cpp
+ * Timing of the stages of a run, counters, and the time spent on each object in each stage.
+ */
+
+#include "Profiler.h"
+#include <cassert>
+#include "third-party/json/json.hpp"
+
+Profiler gProfiler;
+
+Profiler& get_profiler() {
+  return gProfiler;
+}
+
+void Profiler::enable(int worker_count) {
+  m_enabled = true;
+  m_worker_count = worker_count;
+  m_timer.start();
+}
+
+int64_t Profiler::now_ns() const {
+  return m_timer.getNs();
+}
+
+void Profiler::begin_stage(const std::string& name) {
+  if (!m_enabled) {
+    return;
+  }
+  Stage stage;
+  stage.name = name;
+  stage.depth = int(m_open_stages.size());
+  stage.start_ns = now_ns();
+  m_open_stages.push_back(int(m_stages.size()));
+  m_stages.push_back(stage);
+}
+
+void Profiler::end_stage() {
+  if (!m_enabled) {
+    return;
+  }
+  assert(!m_open_stages.empty());
+  auto& stage = m_stages.at(m_open_stages.back());
+  stage.duration_ns = now_ns() - stage.start_ns;
+  m_open_stages.pop_back();
+}
+
+/*!
+ * Add a counter to the innermost stage, or to the whole run if no stage is running.
+ */
+void Profiler::add_counter(const std::string& name, double value) {
+  if (!m_enabled) {
+    return;
+  }
+  if (m_open_stages.empty()) {
+    m_counters.emplace_back(name, value);
+  } else {
+    m_stages.at(m_open_stages.back()).counters.emplace_back(name, value);
+  }
+}
+
+/*!
+ * Add the time spent on an object to the innermost stage.
+ */
+void Profiler::add_object_event(const ObjectEvent& event) {
+  if (!m_enabled || m_open_stages.empty()) {
+    return;
+  }
+  m_stages.at(m_open_stages.back()).objects.push_back(event);
+}
+
+namespace {
+double to_ms(int64_t ns) {
+  return ns / 1.e6;
+}
+
+nlohmann::json counters_to_json(const std::vector<std::pair<std::string, double>>& counters) {
+  auto result = nlohmann::json::object();
+  for (auto& counter : counters) {
+    result[counter.first] = counter.second;
+  }
+  return result;
+}
+}  // namespace
+
+/*!
+ * Write everything as JSON. Stages are in the order they started, and objects in each stage are in
+ * the same order as the dgo listing.
+ */
+std::string Profiler::to_json() const {
+  nlohmann::json result;
+  result["threads"] = m_worker_count;
+  result["total_ms"] = to_ms(now_ns());
+  result["counters"] = counters_to_json(m_counters);
+
+  auto stages = nlohmann::json::array();
+  for (auto& stage : m_stages) {
+    nlohmann::json s;
+    s["name"] = stage.name;
+    s["depth"] = stage.depth;
+    s["start_ms"] = to_ms(stage.start_ns);
+    s["ms"] = to_ms(stage.duration_ns);
+    s["counters"] = counters_to_json(stage.counters);
+
+    auto objects = nlohmann::json::array();
+    for (auto& obj : stage.objects) {
+      nlohmann::json o;
+      o["name"] = obj.object;
+      o["ms"] = to_ms(obj.duration_ns);
+      o["thread"] = obj.worker;
+      objects.push_back(o);
+    }
+    s["objects"] = objects;
+    stages.push_back(s);
+  }
+  result["stages"] = stages;
+
+  return result.dump(1);
+}
+
+/*!
+ * Write stages and objects as Chrome trace events. Stages are on the main thread, which is also
+ * worker 0, and objects are on the worker that processed them. Counters are shown when their stage
+ * ends.
+ */
+std::string Profiler::to_chrome_trace() const {
+  auto events = nlohmann::json::array();
+
+  for (int i = 0; i < m_worker_count; i++) {
+    nlohmann::json e;
+    e["name"] = "thread_name";
+    e["ph"] = "M";
+    e["pid"] = 0;
+    e["tid"] = i;
+    e["args"]["name"] = i == 0 ? std::string("main") : "worker " + std::to_string(i);
+    events.push_back(e);
+  }
+
+  for (auto& stage : m_stages) {
+    nlohmann::json e;
+    e["name"] = stage.name;
+    e["cat"] = "stage";
+    e["ph"] = "X";
+    e["pid"] = 0;
+    e["tid"] = 0;
+    e["ts"] = stage.start_ns / 1.e3;
+    e["dur"] = stage.duration_ns / 1.e3;
+    events.push_back(e);
+
+    for (auto& obj : stage.objects) {
+      nlohmann::json o;
+      o["name"] = obj.object;
+      o["cat"] = stage.name;
+      o["ph"] = "X";
+      o["pid"] = 0;
+      o["tid"] = obj.worker;
+      o["ts"] = obj.start_ns / 1.e3;
+      o["dur"] = obj.duration_ns / 1.e3;
+      events.push_back(o);
+    }
+
+    for (auto& counter : stage.counters) {
+      nlohmann::json c;
+      c["name"] = stage.name + "." + counter.first;
+      c["ph"] = "C";
+      c["pid"] = 0;
+      c["ts"] = (stage.start_ns + stage.duration_ns) / 1.e3;
+      c["args"]["value"] = counter.second;
+      events.push_back(c);
+    }
+  }
+
+  nlohmann::json result;
+  result["traceEvents"] = events;
+  result["displayTimeUnit"] = "ms";
+  return result.dump();
+}
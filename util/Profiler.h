@@ -0,0 +1,80 @@
+/*!
+ * @file Profiler.h
+ * Timing of the stages of a run, counters, and the time spent on each object in each stage.
+ * Can be written as JSON, or as Chrome trace events for chrome://tracing or Perfetto.
+ */
+
+#ifndef JAK_DISASSEMBLER_PROFILER_H
+#define JAK_DISASSEMBLER_PROFILER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "util/Timer.h"
+
+class Profiler {
+ public:
+  /*!
+   * Time spent on one object in a parallel loop. Workers fill these in per-object slots, and the
+   * slots are added to the stage in order afterward.
+   */
+  struct ObjectEvent {
+    std::string object;
+    int64_t start_ns = 0;
+    int64_t duration_ns = 0;
+    int worker = 0;
+  };
+
+  struct Stage {
+    std::string name;
+    int depth = 0;  // number of stages this is inside of
+    int64_t start_ns = 0;
+    int64_t duration_ns = -1;  // -1 until the stage ends
+    std::vector<std::pair<std::string, double>> counters;
+    std::vector<ObjectEvent> objects;
+  };
+
+  /*!
+   * Nothing is recorded unless the profiler is enabled, so the timing costs nothing by default.
+   */
+  void enable(int worker_count);
+  bool enabled() const { return m_enabled; }
+
+  /*!
+   * Time since the profiler was enabled. Safe to call from any thread.
+   */
+  int64_t now_ns() const;
+
+  // These must only be called from the main thread.
+  void begin_stage(const std::string& name);
+  void end_stage();
+  void add_counter(const std::string& name, double value);
+  void add_object_event(const ObjectEvent& event);
+
+  const std::vector<Stage>& stages() const { return m_stages; }
+  std::string to_json() const;
+  std::string to_chrome_trace() const;
+
+ private:
+  bool m_enabled = false;
+  int m_worker_count = 1;
+  mutable Timer m_timer;
+  std::vector<Stage> m_stages;
+  std::vector<int> m_open_stages;                          // indices into m_stages
+  std::vector<std::pair<std::string, double>> m_counters;  // counters added outside of any stage
+};
+
+Profiler& get_profiler();
+
+/*!
+ * Begin a stage, and end it when this goes out of scope.
+ */
+class ScopedStage {
+ public:
+  explicit ScopedStage(const std::string& name) { get_profiler().begin_stage(name); }
+  ~ScopedStage() { get_profiler().end_stage(); }
+  ScopedStage(const ScopedStage&) = delete;
+  ScopedStage& operator=(const ScopedStage&) = delete;
+};
+
+#endif  // JAK_DISASSEMBLER_PROFILER_H
@@ -0,0 +1,121 @@
+/*!
+ * @file SymbolTableBench.cpp
+ * Measure how fast strings can be interned in a SymbolTable from many threads at once, and check
+ * that every thread gets the same pointer for the same string.
+ */
+
+#include "SymbolTableBench.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "util/LispPrint.h"
+#include "util/ThreadPool.h"
+#include "util/Timer.h"
+
+namespace {
+constexpr uint32_t STRING_COUNT = 1 << 16;
+constexpr uint32_t INTERNS_PER_CHUNK = 1 << 14;
+constexpr uint32_t CHUNK_COUNT = 256;
+
+/*!
+ * Strings like the ones that get interned for scripts: symbol names, and numbers.
+ */
+std::vector<std::string> make_strings() {
+  std::vector<std::string> result;
+  for (uint32_t i = 0; i < STRING_COUNT; i++) {
+    if (i % 4 == 3) {
+      result.push_back(std::to_string(i * 2654435761u));
+    } else {
+      result.push_back("*bench-symbol-" + std::to_string(i) + "*");
+    }
+  }
+  return result;
+}
+
+/*!
+ * Get the string used by the n-th intern in a chunk. Squaring a uniform number makes low indices
+ * much more common, so all threads keep interning a few of the same strings, like the common
+ * symbols in scripts.
+ */
+uint32_t pick_string(uint32_t chunk, uint32_t n) {
+  uint64_t x = uint32_t((chunk * INTERNS_PER_CHUNK + n) * 0x9e3779b1u);
+  return uint32_t((x * x) >> 48);
+}
+
+struct BenchResult {
+  double seconds = 0;
+  size_t distinct = 0;
+  bool ok = true;
+};
+
+BenchResult run_with_threads(int threads, const std::vector<std::string>& strings) {
+  BenchResult result;
+  ThreadPool pool(threads);
+  SymbolTable table;
+  std::vector<const std::string*> interned(size_t(CHUNK_COUNT) * INTERNS_PER_CHUNK);
+
+  Timer timer;
+  pool.parallel_for(CHUNK_COUNT, [&](size_t chunk, int) {
+    for (uint32_t n = 0; n < INTERNS_PER_CHUNK; n++) {
+      interned[chunk * INTERNS_PER_CHUNK + n] = table.intern(strings[pick_string(chunk, n)]);
+    }
+  });
+  result.seconds = timer.getSeconds();
+
+  // every intern of a string, from any thread, should have gotten the same pointer.
+  std::vector<const std::string*> first(STRING_COUNT, nullptr);
+  for (uint32_t chunk = 0; chunk < CHUNK_COUNT; chunk++) {
+    for (uint32_t n = 0; n < INTERNS_PER_CHUNK; n++) {
+      auto idx = pick_string(chunk, n);
+      auto* ptr = interned[chunk * INTERNS_PER_CHUNK + n];
+      if (!first[idx]) {
+        first[idx] = ptr;
+        result.distinct++;
+      }
+      if (ptr != first[idx] || *ptr != strings[idx]) {
+        result.ok = false;
+      }
+    }
+  }
+  if (table.size() != result.distinct) {
+    result.ok = false;
+  }
+  return result;
+}
+}  // namespace
+
+/*!
+ * Intern the same sequence of strings with 1, 2, 4, ... up to max_threads threads, and print how
+ * many interns per second each one did.
+ */
+void run_symbol_table_bench(int max_threads) {
+  printf("- Benchmarking SymbolTable interning...\n");
+  auto strings = make_strings();
+
+  std::vector<int> thread_counts;
+  for (int threads = 1; threads < max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(max_threads);
+
+  printf("Benchmarked SymbolTable interning:\n");
+  printf(" %d interns of %d strings per run\n", CHUNK_COUNT * INTERNS_PER_CHUNK, STRING_COUNT);
+  printf(" %8s %16s %10s %9s %8s\n", "threads", "M interns/sec", "speedup", "distinct", "check");
+  double single_thread_rate = 0;
+  bool all_ok = true;
+  for (auto threads : thread_counts) {
+    auto result = run_with_threads(threads, strings);
+    double rate = CHUNK_COUNT * INTERNS_PER_CHUNK / result.seconds;
+    if (threads == 1) {
+      single_thread_rate = rate;
+    }
+    printf(" %8d %16.3f %9.2fx %9d %8s\n", threads, rate / 1.e6, rate / single_thread_rate,
+           int(result.distinct), result.ok ? "ok" : "FAILED");
+    all_ok = all_ok && result.ok;
+  }
+  if (!all_ok) {
+    printf("SymbolTable returned different pointers for the same string!\n");
+  }
+  printf("\n");
+}
@@ -0,0 +1,12 @@
+/*!
+ * @file SymbolTableBench.h
+ * Measure how fast strings can be interned in a SymbolTable from many threads at once, and check
+ * that every thread gets the same pointer for the same string.
+ */
+
+#ifndef JAK_DISASSEMBLER_SYMBOLTABLEBENCH_H
+#define JAK_DISASSEMBLER_SYMBOLTABLEBENCH_H
+
+void run_symbol_table_bench(int max_threads);
+
+#endif  // JAK_DISASSEMBLER_SYMBOLTABLEBENCH_H
@@ -0,0 +1,188 @@
+#include "ThreadPool.h"
+
+#include <cassert>
+
+namespace {
+// the worker id of this thread, if it's currently running a job from a parallel_for.
+thread_local int t_current_worker = -1;
+}  // namespace
+
+ThreadPool::ThreadPool(int n_threads) {
+  if (n_threads < 1) {
+    n_threads = 1;
+  }
+
+  for (int i = 0; i < n_threads; i++) {
+    m_queues.push_back(std::make_unique<WorkQueue>());
+  }
+
+  // worker 0 is the thread calling parallel_for, so we only need n - 1 extra threads.
+  for (int i = 1; i < n_threads; i++) {
+    m_threads.emplace_back(&ThreadPool::thread_main, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shutdown = true;
+  }
+  m_start_cv.notify_all();
+  for (auto& t : m_threads) {
+    t.join();
+  }
+}
+
+/*!
+ * Number of threads to use if the user doesn't ask for a specific number.
+ */
+int ThreadPool::default_thread_count() {
+  int n = int(std::thread::hardware_concurrency());
+  return n > 0 ? n : 1;
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t, int)>& f) {
+  if (count == 0) {
+    return;
+  }
+
+  // a job calling parallel_for again just runs the inner loop itself, as the other workers are
+  // busy with the outer loop.
+  if (t_current_worker >= 0) {
+    for (size_t i = 0; i < count; i++) {
+      f(i, t_current_worker);
+    }
+    return;
+  }
+
+  // no point in waking up other threads, just do it in order.
+  if (m_threads.empty() || count == 1) {
+    t_current_worker = 0;
+    try {
+      for (size_t i = 0; i < count; i++) {
+        f(i, 0);
+      }
+    } catch (...) {
+      t_current_worker = -1;
+      throw;
+    }
+    t_current_worker = -1;
+    return;
+  }
+
+  // split the range evenly to start, stealing will take care of any imbalance.
+  size_t n_workers = m_queues.size();
+  for (size_t i = 0; i < n_workers; i++) {
+    auto& q = *m_queues[i];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    q.begin = (count * i) / n_workers;
+    q.end = (count * (i + 1)) / n_workers;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_job = &f;
+    m_exception = nullptr;
+    m_workers_running = int(m_threads.size());
+    m_generation++;
+  }
+  m_start_cv.notify_all();
+
+  run_worker(0);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done_cv.wait(lock, [&] { return m_workers_running == 0; });
+  m_job = nullptr;
+  if (m_exception) {
+    auto e = m_exception;
+    m_exception = nullptr;
+    std::rethrow_exception(e);
+  }
+}
+
+void ThreadPool::thread_main(int worker_id) {
+  uint64_t last_generation = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_start_cv.wait(lock, [&] { return m_shutdown || m_generation != last_generation; });
+      if (m_shutdown) {
+        return;
+      }
+      last_generation = m_generation;
+    }
+
+    run_worker(worker_id);
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_workers_running--;
+    }
+    m_done_cv.notify_one();
+  }
+}
+
+/*!
+ * Run jobs until there is nothing left in our queue or anybody else's queue.
+ */
+void ThreadPool::run_worker(int worker_id) {
+  size_t idx;
+  t_current_worker = worker_id;
+  while (pop_local(worker_id, &idx) || steal(worker_id, &idx)) {
+    try {
+      (*m_job)(idx, worker_id);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (!m_exception) {
+        m_exception = std::current_exception();
+      }
+      // drop the rest of the work, the caller will see the exception.
+      for (auto& q : m_queues) {
+        std::lock_guard<std::mutex> q_lock(q->mutex);
+        q->begin = q->end;
+      }
+    }
+  }
+  t_current_worker = -1;
+}
+
+bool ThreadPool::pop_local(int worker_id, size_t* idx) {
+  auto& q = *m_queues[worker_id];
+  std::lock_guard<std::mutex> lock(q.mutex);
+  if (q.begin == q.end) {
+    return false;
+  }
+  *idx = q.begin++;
+  return true;
+}
+
+/*!
+ * Take the back half of another worker's range. The first stolen index is returned, and the rest
+ * go in our own queue.
+ */
+bool ThreadPool::steal(int worker_id, size_t* idx) {
+  int n_workers = size();
+  for (int i = 1; i < n_workers; i++) {
+    auto& victim = *m_queues[(worker_id + i) % n_workers];
+    size_t begin, end;
+    {
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      size_t remaining = victim.end - victim.begin;
+      if (remaining == 0) {
+        continue;
+      }
+      end = victim.end;
+      begin = victim.end - (remaining + 1) / 2;
+      victim.end = begin;
+    }
+
+    auto& q = *m_queues[worker_id];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    assert(q.begin == q.end);
+    *idx = begin;
+    q.begin = begin + 1;
+    q.end = end;
+    return true;
+  }
+  return false;
+}
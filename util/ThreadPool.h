@@ -0,0 +1,64 @@
+#ifndef JAK_DISASSEMBLER_THREADPOOL_H
+#define JAK_DISASSEMBLER_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+ * A fixed size pool of worker threads for running parallel loops.
+ * Each worker owns a range of loop indices and works through it from the front. When a worker runs
+ * out of work, it steals the back half of another worker's remaining range.
+ * The thread calling parallel_for acts as worker 0, so a pool of size 1 runs everything in order on
+ * the calling thread.
+ */
+class ThreadPool {
+ public:
+  explicit ThreadPool(int n_threads = 1);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /*!
+   * Run f(idx, worker_id) for every idx in [0, count) and wait for all of them to finish.
+   * worker_id is in [0, size()) and can be used to index per-worker scratch data.
+   * If f throws, the first exception is rethrown here after all workers stop.
+   * If f calls parallel_for itself, the inner loop runs on the calling worker.
+   */
+  void parallel_for(size_t count, const std::function<void(size_t, int)>& f);
+
+  int size() const { return int(m_queues.size()); }
+
+  static int default_thread_count();
+
+ private:
+  struct WorkQueue {
+    std::mutex mutex;
+    size_t begin = 0;
+    size_t end = 0;
+  };
+
+  void thread_main(int worker_id);
+  void run_worker(int worker_id);
+  bool pop_local(int worker_id, size_t* idx);
+  bool steal(int worker_id, size_t* idx);
+
+  std::vector<std::unique_ptr<WorkQueue>> m_queues;
+  std::vector<std::thread> m_threads;
+
+  std::mutex m_mutex;
+  std::condition_variable m_start_cv, m_done_cv;
+  uint64_t m_generation = 0;
+  int m_workers_running = 0;
+  bool m_shutdown = false;
+
+  const std::function<void(size_t, int)>* m_job = nullptr;
+  std::exception_ptr m_exception;
+};
+
+#endif  // JAK_DISASSEMBLER_THREADPOOL_H